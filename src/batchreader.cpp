@@ -0,0 +1,388 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "batchreader.h"
+
+namespace {
+
+thread_local BatchScope* t_scope = nullptr;
+
+// user_data of the linked read / close pairs
+const unsigned long long OP_CLOSE = 1;
+
+int ioUringSetup(unsigned int entries, struct io_uring_params* params)
+{
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+int ioUringEnter(int ring_fd, unsigned int submit, unsigned int wait, unsigned int flags)
+{
+    return syscall(__NR_io_uring_enter, ring_fd, submit, wait, flags, nullptr, 0);
+}
+
+int ioUringRegister(int ring_fd, unsigned int opcode, void* arg, unsigned int nr_args)
+{
+    return syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args);
+}
+
+// the kernel can be older than the header
+bool supportsOps(int ring_fd)
+{
+    const unsigned int nr_ops = 256;
+    size_t size = sizeof(struct io_uring_probe) + nr_ops * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe* probe = static_cast<struct io_uring_probe*>(calloc(1, size));
+    if (probe == nullptr)
+        return false;
+    bool supported = false;
+    if (ioUringRegister(ring_fd, IORING_REGISTER_PROBE, probe, nr_ops) == 0)
+    {
+        supported = true;
+        for (int op : {IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE})
+        {
+            if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED))
+                supported = false;
+        }
+    }
+    free(probe);
+    return supported;
+}
+
+} // namespace
+
+BatchReader::BatchReader(unsigned int depth)
+    : m_ring_fd(-1), m_entries(0), m_sq_ring(MAP_FAILED), m_sq_ring_size(0),
+      m_cq_ring(MAP_FAILED), m_cq_ring_size(0), m_sqes(static_cast<struct io_uring_sqe*>(MAP_FAILED)),
+      m_sq_tail(nullptr), m_sq_mask(nullptr), m_sq_array(nullptr),
+      m_cq_head(nullptr), m_cq_tail(nullptr), m_cq_mask(nullptr), m_cqes(nullptr), m_syscalls(0)
+{
+    // a read and its close take two entries
+    if (depth < 2 || !setup(depth))
+        teardown();
+}
+
+BatchReader::~BatchReader()
+{
+    teardown();
+}
+
+bool BatchReader::setup(unsigned int depth)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    m_ring_fd = ioUringSetup(depth, &params);
+    if (m_ring_fd < 0)
+        return false;
+    if (!supportsOps(m_ring_fd))
+        return false;
+    m_entries = params.sq_entries;
+
+    m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    m_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap)
+        m_sq_ring_size = m_cq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+
+    m_sq_ring = mmap(nullptr, m_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     m_ring_fd, IORING_OFF_SQ_RING);
+    if (m_sq_ring == MAP_FAILED)
+        return false;
+    if (single_mmap)
+    {
+        m_cq_ring = m_sq_ring;
+    }
+    else
+    {
+        m_cq_ring = mmap(nullptr, m_cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         m_ring_fd, IORING_OFF_CQ_RING);
+        if (m_cq_ring == MAP_FAILED)
+            return false;
+    }
+    m_sqes = static_cast<struct io_uring_sqe*>(mmap(nullptr, params.sq_entries * sizeof(struct io_uring_sqe),
+                                                    PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                                    m_ring_fd, IORING_OFF_SQES));
+    if (m_sqes == MAP_FAILED)
+        return false;
+
+    char* sq = static_cast<char*>(m_sq_ring);
+    m_sq_tail = reinterpret_cast<unsigned int*>(sq + params.sq_off.tail);
+    m_sq_mask = reinterpret_cast<unsigned int*>(sq + params.sq_off.ring_mask);
+    m_sq_array = reinterpret_cast<unsigned int*>(sq + params.sq_off.array);
+    char* cq = static_cast<char*>(m_cq_ring);
+    m_cq_head = reinterpret_cast<unsigned int*>(cq + params.cq_off.head);
+    m_cq_tail = reinterpret_cast<unsigned int*>(cq + params.cq_off.tail);
+    m_cq_mask = reinterpret_cast<unsigned int*>(cq + params.cq_off.ring_mask);
+    m_cqes = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+}
+
+void BatchReader::teardown()
+{
+    if (m_sqes != MAP_FAILED)
+        munmap(m_sqes, m_entries * sizeof(struct io_uring_sqe));
+    if (m_cq_ring != MAP_FAILED && m_cq_ring != m_sq_ring)
+        munmap(m_cq_ring, m_cq_ring_size);
+    if (m_sq_ring != MAP_FAILED)
+        munmap(m_sq_ring, m_sq_ring_size);
+    if (m_ring_fd != -1)
+        close(m_ring_fd);
+    m_sqes = static_cast<struct io_uring_sqe*>(MAP_FAILED);
+    m_cq_ring = MAP_FAILED;
+    m_sq_ring = MAP_FAILED;
+    m_ring_fd = -1;
+}
+
+bool BatchReader::isUring() const
+{
+    return m_ring_fd != -1;
+}
+
+unsigned long BatchReader::syscalls() const
+{
+    return m_syscalls;
+}
+
+void BatchReader::read(std::vector<struct batch_read_t>& reads)
+{
+    if (!isUring())
+    {
+        for (struct batch_read_t& read : reads)
+            readSync(read);
+        return;
+    }
+    // every read of a chunk is in flight at once
+    size_t chunk = m_entries / 2;
+    for (size_t begin = 0; begin < reads.size(); begin += chunk)
+    {
+        if (!isUring())
+        {
+            // the ring failed during a previous chunk
+            for (size_t i = begin; i < reads.size(); i++)
+                readSync(reads[i]);
+            return;
+        }
+        readChunk(&reads[begin], std::min(chunk, reads.size() - begin));
+    }
+}
+
+void BatchReader::readSync(struct batch_read_t& read)
+{
+    read.content.clear();
+    m_syscalls++;
+    int fd = open(read.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        read.result = -errno;
+        return;
+    }
+    char buf[buffer_size];
+    while (true)
+    {
+        m_syscalls++;
+        ssize_t nread = ::read(fd, buf, sizeof(buf));
+        if (nread < 0 && errno == EINTR)
+            continue;
+        if (nread < 0)
+        {
+            // the process exited while reading
+            read.result = -errno;
+            read.content.clear();
+            m_syscalls++;
+            close(fd);
+            return;
+        }
+        if (nread == 0)
+            break;
+        read.content.append(buf, nread);
+    }
+    m_syscalls++;
+    close(fd);
+    read.result = read.content.size();
+}
+
+struct io_uring_sqe* BatchReader::nextSqe()
+{
+    // only this thread writes the tail
+    unsigned int tail = *m_sq_tail;
+    unsigned int index = tail & *m_sq_mask;
+    struct io_uring_sqe* sqe = &m_sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    m_sq_array[index] = index;
+    __atomic_store_n(m_sq_tail, tail + 1, __ATOMIC_RELEASE);
+    return sqe;
+}
+
+enum BatchReader::submit_result BatchReader::submitAndWait(
+        unsigned int submit, unsigned int wait,
+        const std::function<void(unsigned long long user_data, int res)>& callback)
+{
+    unsigned int submitted = 0;
+    unsigned int reaped = 0;
+    while (reaped < wait)
+    {
+        // the kernel does not wait when it could not submit everything
+        int ret = ioUringEnter(m_ring_fd, submit - submitted, wait - reaped, IORING_ENTER_GETEVENTS);
+        m_syscalls++;
+        if (ret < 0)
+        {
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+                break;
+        }
+        else
+        {
+            submitted += ret;
+        }
+        reap(reaped, callback);
+    }
+    if (reaped == wait)
+        return SUBMIT_DONE;
+
+    // what was submitted completes anyway, reap it before the ring goes
+    // away so that no fd or buffer is left to the kernel
+    while (reaped < submitted)
+    {
+        int ret = ioUringEnter(m_ring_fd, 0, submitted - reaped, IORING_ENTER_GETEVENTS);
+        m_syscalls++;
+        if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            break;
+        reap(reaped, callback);
+    }
+    return reaped == submitted ? SUBMIT_DRAINED : SUBMIT_PENDING;
+}
+
+void BatchReader::reap(unsigned int& reaped,
+                       const std::function<void(unsigned long long user_data, int res)>& callback)
+{
+    unsigned int head = *m_cq_head;
+    while (head != __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE))
+    {
+        const struct io_uring_cqe& cqe = m_cqes[head & *m_cq_mask];
+        callback(cqe.user_data, cqe.res);
+        head++;
+        reaped++;
+    }
+    __atomic_store_n(m_cq_head, head, __ATOMIC_RELEASE);
+}
+
+void BatchReader::readChunk(struct batch_read_t* reads, size_t count)
+{
+    std::vector<int> fds(count, -1);
+    for (size_t i = 0; i < count; i++)
+    {
+        reads[i].content.clear();
+        struct io_uring_sqe* sqe = nextSqe();
+        sqe->opcode = IORING_OP_OPENAT;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = reinterpret_cast<unsigned long>(reads[i].path.c_str());
+        sqe->open_flags = O_RDONLY | O_CLOEXEC;
+        sqe->user_data = i;
+    }
+    enum submit_result result = submitAndWait(count, count, [reads, &fds](unsigned long long user_data, int res) {
+        if (res < 0)
+            reads[user_data].result = res;
+        else
+            fds[user_data] = res;
+    });
+    if (result != SUBMIT_DONE)
+    {
+        // an open still in flight after teardown() is lost with its fd
+        for (int fd : fds)
+            if (fd != -1)
+                close(fd);
+        teardown();
+        for (size_t i = 0; i < count; i++)
+            readSync(reads[i]);
+        return;
+    }
+
+    // the close runs even if the read fails
+    unsigned int linked = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (fds[i] == -1)
+            continue;
+        reads[i].content.resize(buffer_size);
+        struct io_uring_sqe* sqe = nextSqe();
+        sqe->opcode = IORING_OP_READ;
+        sqe->flags = IOSQE_IO_HARDLINK;
+        sqe->fd = fds[i];
+        sqe->addr = reinterpret_cast<unsigned long>(&reads[i].content[0]);
+        sqe->len = buffer_size;
+        sqe->off = 0;
+        sqe->user_data = i << 1;
+        sqe = nextSqe();
+        sqe->opcode = IORING_OP_CLOSE;
+        sqe->fd = fds[i];
+        sqe->user_data = (i << 1) | OP_CLOSE;
+        linked += 2;
+    }
+    // which reads and closes completed, for the error path
+    std::vector<bool> read_done(count, false);
+    std::vector<bool> closed(count, false);
+    result = submitAndWait(linked, linked, [reads, &read_done, &closed](unsigned long long user_data, int res) {
+        size_t i = user_data >> 1;
+        if (user_data & OP_CLOSE)
+        {
+            // a cancelled close did not run
+            closed[i] = res != -ECANCELED;
+            return;
+        }
+        struct batch_read_t& read = reads[i];
+        read.result = res;
+        read.content.resize(res > 0 ? res : 0);
+        read_done[i] = true;
+    });
+    if (result != SUBMIT_DONE)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (fds[i] == -1)
+                continue;
+            // with entries in flight, the kernel may still close the fd
+            if (!closed[i] && result == SUBMIT_DRAINED)
+                close(fds[i]);
+            if (!read_done[i])
+                reads[i].result = -ECANCELED;
+        }
+        teardown();
+    }
+
+    // larger than the buffer, or not read because the ring failed
+    for (size_t i = 0; i < count; i++)
+    {
+        if (reads[i].result == static_cast<ssize_t>(buffer_size) || reads[i].result == -ECANCELED)
+            readSync(reads[i]);
+    }
+}
+
+BatchScope::BatchScope(const std::vector<struct batch_read_t>& reads)
+    : m_reads(reads), m_parent(t_scope)
+{
+    m_index.reserve(reads.size());
+    for (size_t i = 0; i < reads.size(); i++)
+        m_index.emplace(reads[i].path, i);
+    t_scope = this;
+}
+
+BatchScope::~BatchScope()
+{
+    t_scope = m_parent;
+}
+
+const struct batch_read_t* BatchScope::find(const std::string& path)
+{
+    for (BatchScope* scope = t_scope; scope != nullptr; scope = scope->m_parent)
+    {
+        std::unordered_map<std::string, size_t>::const_iterator it = scope->m_index.find(path);
+        if (it != scope->m_index.end())
+            return &scope->m_reads[it->second];
+    }
+    return nullptr;
+}
@@ -0,0 +1,110 @@
+#ifndef BATCHREADER_H
+#define BATCHREADER_H
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/types.h>
+
+// one file of a batch
+struct batch_read_t
+{
+    std::string path;
+    std::string content;
+    // bytes read, -errno if the file cannot be read
+    ssize_t result;
+};
+
+// Reads many small files with a handful of syscalls
+//
+// The files are opened by a batch of IORING_OP_OPENAT, then each one is
+// read and closed by a IORING_OP_READ hard linked to a IORING_OP_CLOSE,
+// so a batch costs two io_uring_enter() whatever its size. The ring is set
+// up with the raw syscalls. When io_uring is missing, disabled by seccomp
+// or lacks one of the operations, the files are read synchronously. If
+// io_uring_enter() fails in the middle of a batch, the ring is torn down
+// and the rest of the batch, like the next ones, is read synchronously.
+class BatchReader
+{
+public:
+    // depth is the number of submission queue entries
+    BatchReader(unsigned int depth = 256);
+    ~BatchReader();
+
+    BatchReader(const BatchReader&) = delete;
+    BatchReader& operator=(const BatchReader&) = delete;
+
+    // false if the files are read with open/read/close
+    bool isUring() const;
+
+    void read(std::vector<struct batch_read_t>& reads);
+
+    // syscalls made by read(), io_uring_enter() or open/read/close
+    unsigned long syscalls() const;
+
+    // a read filling the buffer is completed synchronously
+    static const size_t buffer_size = 4096;
+
+private:
+    bool setup(unsigned int depth);
+    void teardown();
+    void readSync(struct batch_read_t& read);
+    void readChunk(struct batch_read_t* reads, size_t count);
+    struct io_uring_sqe* nextSqe();
+
+    enum submit_result
+    {
+        // every entry completed
+        SUBMIT_DONE,
+        // failed, but every submitted entry completed
+        SUBMIT_DRAINED,
+        // failed with submitted entries still in flight
+        SUBMIT_PENDING
+    };
+    enum submit_result submitAndWait(unsigned int submit, unsigned int wait,
+                                     const std::function<void(unsigned long long user_data, int res)>& callback);
+    // completions of a chunk since its last submit
+    void reap(unsigned int& reaped,
+              const std::function<void(unsigned long long user_data, int res)>& callback);
+
+    int m_ring_fd;
+    unsigned int m_entries;
+    void* m_sq_ring;
+    size_t m_sq_ring_size;
+    void* m_cq_ring;
+    size_t m_cq_ring_size;
+    struct io_uring_sqe* m_sqes;
+    // pointers into the rings
+    unsigned int* m_sq_tail;
+    unsigned int* m_sq_mask;
+    unsigned int* m_sq_array;
+    unsigned int* m_cq_head;
+    unsigned int* m_cq_tail;
+    unsigned int* m_cq_mask;
+    struct io_uring_cqe* m_cqes;
+    unsigned long m_syscalls;
+};
+
+// Serves the files of a batch to ProcStream and readProcFile() on the
+// calling thread while it is in scope, the other paths are read as usual
+class BatchScope
+{
+public:
+    BatchScope(const std::vector<struct batch_read_t>& reads);
+    ~BatchScope();
+
+    BatchScope(const BatchScope&) = delete;
+    BatchScope& operator=(const BatchScope&) = delete;
+
+    // nullptr if path is not part of the active batch
+    static const struct batch_read_t* find(const std::string& path);
+
+private:
+    const std::vector<struct batch_read_t>& m_reads;
+    std::unordered_map<std::string, size_t> m_index;
+    BatchScope* m_parent;
+};
+
+#endif // BATCHREADER_H
@@ -0,0 +1,258 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <boost/utility/string_view.hpp>
+
+#include "cgroupreader.h"
+#include "procfs.h"
+
+namespace {
+
+const char* const CGROUP_FILE_NAMES[CGROUP_FILE_COUNT] = {
+    "cpu.stat", "memory.current", "memory.stat", "io.stat", "pids.current"
+};
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\n';
+}
+
+// next token of buf, empty at the end
+boost::string_view nextToken(const char*& pos, const char* end)
+{
+    while (pos < end && isSpace(*pos))
+        pos++;
+    const char* begin = pos;
+    while (pos < end && !isSpace(*pos))
+        pos++;
+    return boost::string_view(begin, pos - begin);
+}
+
+unsigned long long toNumber(boost::string_view token)
+{
+    unsigned long long number = 0;
+    for (char c : token)
+    {
+        if (c < '0' || c > '9')
+            break;
+        number = number * 10 + (c - '0');
+    }
+    return number;
+}
+
+// "key value" lines of cpu.stat and memory.stat
+void parseFlatKeyed(const char* buf, size_t len, struct cgroup_stat_t& stat, bool memory)
+{
+    const char* pos = buf;
+    const char* end = buf + len;
+    while (true)
+    {
+        boost::string_view key = nextToken(pos, end);
+        if (key.empty())
+            break;
+        unsigned long long value = toNumber(nextToken(pos, end));
+        if (!memory)
+        {
+            if (key == "usage_usec")
+                stat.usage_usec = value;
+            else if (key == "user_usec")
+                stat.user_usec = value;
+            else if (key == "system_usec")
+                stat.system_usec = value;
+            else if (key == "nr_periods")
+                stat.nr_periods = value;
+            else if (key == "nr_throttled")
+                stat.nr_throttled = value;
+            else if (key == "throttled_usec")
+                stat.throttled_usec = value;
+        }
+        else
+        {
+            if (key == "anon")
+                stat.anon = value;
+            else if (key == "file")
+                stat.file = value;
+            else if (key == "kernel_stack")
+                stat.kernel_stack = value;
+            else if (key == "sock")
+                stat.sock = value;
+            else if (key == "shmem")
+                stat.shmem = value;
+            else if (key == "file_mapped")
+                stat.file_mapped = value;
+            else if (key == "file_dirty")
+                stat.file_dirty = value;
+            else if (key == "pgfault")
+                stat.pgfault = value;
+            else if (key == "pgmajfault")
+                stat.pgmajfault = value;
+        }
+    }
+}
+
+// "8:0 rbytes=1 wbytes=2 rios=3 wios=4 dbytes=0 dios=0" per device
+void parseIoStat(const char* buf, size_t len, struct cgroup_stat_t& stat)
+{
+    stat.rbytes = stat.wbytes = stat.rios = stat.wios = 0;
+    const char* pos = buf;
+    const char* end = buf + len;
+    while (true)
+    {
+        boost::string_view token = nextToken(pos, end);
+        if (token.empty())
+            break;
+        size_t equal = token.find('=');
+        if (equal == boost::string_view::npos)
+            continue; // device
+        boost::string_view key = token.substr(0, equal);
+        unsigned long long value = toNumber(token.substr(equal + 1));
+        if (key == "rbytes")
+            stat.rbytes += value;
+        else if (key == "wbytes")
+            stat.wbytes += value;
+        else if (key == "rios")
+            stat.rios += value;
+        else if (key == "wios")
+            stat.wios += value;
+    }
+}
+
+} // namespace
+
+CgroupReader::CgroupReader()
+{
+}
+
+CgroupReader::~CgroupReader()
+{
+    for (std::pair<const std::string, struct cgroup_entry_t>& it : m_cgroups)
+        close(it.second);
+}
+
+bool CgroupReader::add(const std::string& path)
+{
+    if (m_cgroups.find(path) != m_cgroups.end())
+        return true;
+    std::string dir_path = cgroupRoot() + (path == "/" ? std::string() : path);
+    int dir_fd = open(dir_path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd == -1)
+        return false;
+
+    struct cgroup_entry_t& entry = m_cgroups[path];
+    entry.stat = cgroup_stat_t();
+    entry.stat.path = path;
+    // a file is missing when its controller is not enabled
+    for (int i = 0; i < CGROUP_FILE_COUNT; i++)
+        entry.fds[i] = openat(dir_fd, CGROUP_FILE_NAMES[i], O_RDONLY | O_CLOEXEC);
+    ::close(dir_fd);
+    return true;
+}
+
+void CgroupReader::addProcesses(std::vector<ProcessInfo>& processes)
+{
+    for (std::pair<const std::string, struct cgroup_entry_t>& it : m_cgroups)
+        it.second.stat.pids.clear();
+    for (ProcessInfo& pinfo : processes)
+    {
+        boost::string_view cgroup = pinfo.unifiedCgroup();
+        if (cgroup.empty())
+            continue;
+        std::string path(cgroup.data(), cgroup.size());
+        if (!add(path))
+            continue;
+        m_cgroups[path].stat.pids.push_back(pinfo.pid());
+    }
+}
+
+void CgroupReader::remove(const std::string& path)
+{
+    std::map<std::string, struct cgroup_entry_t>::iterator it = m_cgroups.find(path);
+    if (it == m_cgroups.end())
+        return;
+    close(it->second);
+    m_cgroups.erase(it);
+}
+
+void CgroupReader::sample()
+{
+    std::map<std::string, struct cgroup_entry_t>::iterator it = m_cgroups.begin();
+    while (it != m_cgroups.end())
+    {
+        if (read(it->second))
+        {
+            ++it;
+            continue;
+        }
+        close(it->second);
+        it = m_cgroups.erase(it);
+    }
+}
+
+std::vector<std::string> CgroupReader::paths() const
+{
+    std::vector<std::string> paths;
+    paths.reserve(m_cgroups.size());
+    for (const std::pair<const std::string, struct cgroup_entry_t>& it : m_cgroups)
+        paths.push_back(it.first);
+    return paths;
+}
+
+const struct cgroup_stat_t* CgroupReader::stat(const std::string& path) const
+{
+    std::map<std::string, struct cgroup_entry_t>::const_iterator it = m_cgroups.find(path);
+    return it == m_cgroups.end() ? nullptr : &it->second.stat;
+}
+
+bool CgroupReader::read(struct cgroup_entry_t& entry)
+{
+    struct cgroup_stat_t& stat = entry.stat;
+    stat.available = 0;
+    char buf[16384];
+    for (int i = 0; i < CGROUP_FILE_COUNT; i++)
+    {
+        if (entry.fds[i] == -1)
+            continue;
+        // the kernel regenerates the content at offset 0
+        ssize_t len = pread(entry.fds[i], buf, sizeof(buf), 0);
+        if (len < 0)
+        {
+            if (errno == ENODEV || errno == ENOENT)
+                return false; // rmdir of the cgroup
+            continue;
+        }
+        stat.available |= 1u << i;
+        switch (i)
+        {
+        case CGROUP_CPU_STAT:
+            parseFlatKeyed(buf, len, stat, false);
+            break;
+        case CGROUP_MEMORY_CURRENT:
+            stat.memory_current = toNumber(boost::string_view(buf, len));
+            break;
+        case CGROUP_MEMORY_STAT:
+            parseFlatKeyed(buf, len, stat, true);
+            break;
+        case CGROUP_IO_STAT:
+            parseIoStat(buf, len, stat);
+            break;
+        case CGROUP_PIDS_CURRENT:
+            stat.pids_current = toNumber(boost::string_view(buf, len));
+            break;
+        }
+    }
+    return true;
+}
+
+void CgroupReader::close(struct cgroup_entry_t& entry)
+{
+    for (int& fd : entry.fds)
+    {
+        if (fd != -1)
+            ::close(fd);
+        fd = -1;
+    }
+}
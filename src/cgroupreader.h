@@ -0,0 +1,108 @@
+#ifndef CGROUPREADER_H
+#define CGROUPREADER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "processinfo.h"
+
+// accounting files of a cgroup v2
+enum cgroup_file
+{
+    CGROUP_CPU_STAT,
+    CGROUP_MEMORY_CURRENT,
+    CGROUP_MEMORY_STAT,
+    CGROUP_IO_STAT,
+    CGROUP_PIDS_CURRENT,
+    CGROUP_FILE_COUNT
+};
+
+struct cgroup_stat_t
+{
+    // relative to cgroupRoot(), "/" for the root cgroup
+    std::string path;
+    // 1 << cgroup_file for each file read by the last sample, a controller
+    // which is not enabled has no file
+    unsigned int available;
+
+    // cpu.stat, in microseconds
+    unsigned long long usage_usec;
+    unsigned long long user_usec;
+    unsigned long long system_usec;
+    unsigned long long nr_periods;
+    unsigned long long nr_throttled;
+    unsigned long long throttled_usec;
+
+    // memory.current, in bytes
+    unsigned long long memory_current;
+    // memory.stat, in bytes
+    unsigned long long anon;
+    unsigned long long file;
+    unsigned long long kernel_stack;
+    unsigned long long sock;
+    unsigned long long shmem;
+    unsigned long long file_mapped;
+    unsigned long long file_dirty;
+    unsigned long long pgfault;
+    unsigned long long pgmajfault;
+
+    // io.stat, summed over the devices
+    unsigned long long rbytes;
+    unsigned long long wbytes;
+    unsigned long long rios;
+    unsigned long long wios;
+
+    // pids.current
+    unsigned long long pids_current;
+
+    // processes given to addProcesses() which are in this cgroup
+    std::vector<pid_t> pids;
+};
+
+// Per cgroup accounting, read from the cgroup v2 files
+//
+// Each cgroup keeps its accounting files open and sample() rereads them
+// with pread() at offset 0, so a sample costs one syscall per file and
+// per cgroup, whatever the number of processes inside. The totals come
+// from the kernel, including the processes which already exited.
+class CgroupReader
+{
+public:
+    CgroupReader();
+    ~CgroupReader();
+
+    CgroupReader(const CgroupReader&) = delete;
+    CgroupReader& operator=(const CgroupReader&) = delete;
+
+    // path relative to cgroupRoot(), false if the cgroup does not exist
+    bool add(const std::string& path);
+    // adds the cgroup of each process and lists its pids, the processes
+    // without a cgroup v2 are skipped
+    void addProcesses(std::vector<ProcessInfo>& processes);
+    void remove(const std::string& path);
+
+    // reads every cgroup, the removed ones are dropped
+    void sample();
+
+    std::vector<std::string> paths() const;
+    // nullptr for an unknown cgroup
+    const struct cgroup_stat_t* stat(const std::string& path) const;
+
+private:
+    struct cgroup_entry_t
+    {
+        int fds[CGROUP_FILE_COUNT];
+        struct cgroup_stat_t stat;
+    };
+
+    // false once the cgroup is removed
+    bool read(struct cgroup_entry_t& entry);
+    void close(struct cgroup_entry_t& entry);
+
+    std::map<std::string, struct cgroup_entry_t> m_cgroups;
+};
+
+#endif // CGROUPREADER_H
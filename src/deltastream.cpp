@@ -0,0 +1,457 @@
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+
+#include <unistd.h>
+
+#include "deltastream.h"
+#include "processinfo.h"
+
+namespace {
+
+#define FRAME_MAGIC 0x41544c44 // "DLTA"
+
+struct frame_header_t
+{
+    uint32_t magic;
+    uint32_t type;
+    uint64_t payload_size;
+    // since epoch
+    int64_t timestamp;
+};
+
+// numeric fields of process_record_t sent by the stream, in bitmask order
+struct record_field_t
+{
+    size_t offset;
+    size_t size;
+    bool is_signed;
+};
+
+#define RECORD_FIELD(name, is_signed) \
+    { offsetof(struct process_record_t, name), sizeof(process_record_t::name), is_signed }
+
+const struct record_field_t RECORD_FIELDS[] = {
+    RECORD_FIELD(ppid, true),
+    RECORD_FIELD(pgid, true),
+    RECORD_FIELD(sid, true),
+    RECORD_FIELD(tty_nr, true),
+    RECORD_FIELD(processor, true),
+    RECORD_FIELD(uid, false),
+    RECORD_FIELD(gid, false),
+    RECORD_FIELD(flags, false),
+    RECORD_FIELD(cpu_usage, true),
+    RECORD_FIELD(priority, true),
+    RECORD_FIELD(nice, true),
+    RECORD_FIELD(num_threads, false),
+    RECORD_FIELD(utime, false),
+    RECORD_FIELD(stime, false),
+    RECORD_FIELD(cutime, false),
+    RECORD_FIELD(cstime, false),
+    RECORD_FIELD(minflt, false),
+    RECORD_FIELD(majflt, false),
+    RECORD_FIELD(starttime, false),
+    RECORD_FIELD(vm_size, false),
+    RECORD_FIELD(vm_rss, false),
+    RECORD_FIELD(vm_swap, false),
+    RECORD_FIELD(read_bytes, false),
+    RECORD_FIELD(write_bytes, false),
+    RECORD_FIELD(state, false),
+};
+const int NB_RECORD_FIELDS = sizeof(RECORD_FIELDS) / sizeof(RECORD_FIELDS[0]);
+// the strings come after the numeric fields in the bitmask
+const int NAME_BIT = NB_RECORD_FIELDS;
+const int EXE_BIT = NB_RECORD_FIELDS + 1;
+const int CMDLINE_BIT = NB_RECORD_FIELDS + 2;
+
+int64_t load(const struct process_record_t& record, const struct record_field_t& field)
+{
+    const char* src = reinterpret_cast<const char*>(&record) + field.offset;
+    switch (field.size)
+    {
+    case 1:
+        return static_cast<unsigned char>(*src);
+    case 4:
+        if (field.is_signed)
+        {
+            int32_t value;
+            memcpy(&value, src, 4);
+            return value;
+        }
+        else
+        {
+            uint32_t value;
+            memcpy(&value, src, 4);
+            return value;
+        }
+    default:
+        int64_t value;
+        memcpy(&value, src, 8);
+        return value;
+    }
+}
+
+void store(struct process_record_t& record, const struct record_field_t& field, int64_t value)
+{
+    char* dst = reinterpret_cast<char*>(&record) + field.offset;
+    if (field.size == 1)
+    {
+        *dst = static_cast<char>(value);
+    }
+    else if (field.size == 4)
+    {
+        uint32_t truncated = static_cast<uint32_t>(value);
+        memcpy(dst, &truncated, 4);
+    }
+    else
+    {
+        memcpy(dst, &value, 8);
+    }
+}
+
+uint64_t zigzag(int64_t value)
+{
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value)
+{
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// difference modulo 2^64, so that counters wrapping around are not an issue
+int64_t difference(int64_t a, int64_t b)
+{
+    return static_cast<int64_t>(static_cast<uint64_t>(a) - static_cast<uint64_t>(b));
+}
+
+void putVarint(std::string& out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void putString(std::string& out, const std::string& str)
+{
+    putVarint(out, str.size());
+    out.append(str);
+}
+
+void putEntry(std::string& out, const struct DeltaEncoder::entry_t& entry)
+{
+    putVarint(out, entry.record.pid);
+    for (int i = 0; i < NB_RECORD_FIELDS; i++)
+        putVarint(out, zigzag(load(entry.record, RECORD_FIELDS[i])));
+    putString(out, entry.name);
+    putString(out, entry.exe);
+    putString(out, entry.cmdline);
+}
+
+// bounds checked reader of a payload
+struct cursor_t
+{
+    const char* cur;
+    const char* end;
+
+    uint64_t varint()
+    {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (cur == end)
+                throw std::string("truncated delta frame");
+            unsigned char byte = *cur++;
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+                return value;
+        }
+        throw std::string("corrupted delta frame");
+    }
+
+    std::string string()
+    {
+        uint64_t size = varint();
+        if (size > static_cast<uint64_t>(end - cur))
+            throw std::string("truncated delta frame");
+        std::string str(cur, size);
+        cur += size;
+        return str;
+    }
+
+    void entry(struct DeltaEncoder::entry_t& entry)
+    {
+        memset(&entry.record, 0, sizeof(entry.record));
+        entry.record.pid = varint();
+        for (int i = 0; i < NB_RECORD_FIELDS; i++)
+            store(entry.record, RECORD_FIELDS[i], unzigzag(varint()));
+        entry.name = string();
+        entry.exe = string();
+        entry.cmdline = string();
+    }
+};
+
+} // namespace
+
+DeltaEncoder::DeltaEncoder(int fd, unsigned int keyframe_interval)
+    : m_fd(fd),
+      m_keyframe_interval(keyframe_interval == 0 ? 1 : keyframe_interval),
+      m_since_keyframe(0),
+      m_need_keyframe(true)
+{
+}
+
+void DeltaEncoder::write(std::vector<ProcessInfo>& processes, std::chrono::system_clock::time_point time)
+{
+    m_records.resize(processes.size());
+    m_strings.clear();
+    for (size_t i = 0; i < processes.size(); i++)
+        fillRecord(processes[i], m_records[i], m_strings);
+    write(m_records, m_strings, time);
+}
+
+void DeltaEncoder::write(const std::vector<struct process_record_t>& records, const StringTable& strings,
+                         std::chrono::system_clock::time_point time)
+{
+    const std::string& table = strings.data();
+    std::map<pid_t, struct entry_t> current;
+    for (const struct process_record_t& record : records)
+    {
+        struct entry_t& entry = current[record.pid];
+        entry.record = record;
+        entry.name = table.c_str() + record.name;
+        entry.exe = table.c_str() + record.exe;
+        entry.cmdline = table.c_str() + record.cmdline;
+    }
+
+    m_payload.clear();
+    bool keyframe = m_need_keyframe || m_since_keyframe + 1 >= m_keyframe_interval;
+    if (keyframe)
+    {
+        putVarint(m_payload, current.size());
+        for (const std::pair<const pid_t, struct entry_t>& it : current)
+            putEntry(m_payload, it.second);
+        m_since_keyframe = 0;
+        m_need_keyframe = false;
+    }
+    else
+    {
+        // removed
+        std::vector<pid_t> removed;
+        for (const std::pair<const pid_t, struct entry_t>& it : m_previous)
+            if (current.find(it.first) == current.end())
+                removed.push_back(it.first);
+        putVarint(m_payload, removed.size());
+        for (pid_t pid : removed)
+            putVarint(m_payload, pid);
+
+        // added
+        std::vector<const struct entry_t*> added;
+        for (const std::pair<const pid_t, struct entry_t>& it : current)
+            if (m_previous.find(it.first) == m_previous.end())
+                added.push_back(&it.second);
+        putVarint(m_payload, added.size());
+        for (const struct entry_t* entry : added)
+            putEntry(m_payload, *entry);
+
+        // changed, the count is known once the records have been compared
+        std::string changed;
+        size_t nb_changed = 0;
+        for (const std::pair<const pid_t, struct entry_t>& it : current)
+        {
+            std::map<pid_t, struct entry_t>::const_iterator previous = m_previous.find(it.first);
+            if (previous == m_previous.end())
+                continue;
+            const struct entry_t& old_entry = previous->second;
+            const struct entry_t& new_entry = it.second;
+
+            uint64_t mask = 0;
+            int64_t diffs[NB_RECORD_FIELDS];
+            for (int i = 0; i < NB_RECORD_FIELDS; i++)
+            {
+                diffs[i] = difference(load(new_entry.record, RECORD_FIELDS[i]),
+                                      load(old_entry.record, RECORD_FIELDS[i]));
+                if (diffs[i] != 0)
+                    mask |= 1ULL << i;
+            }
+            if (new_entry.name != old_entry.name)
+                mask |= 1ULL << NAME_BIT;
+            if (new_entry.exe != old_entry.exe)
+                mask |= 1ULL << EXE_BIT;
+            if (new_entry.cmdline != old_entry.cmdline)
+                mask |= 1ULL << CMDLINE_BIT;
+            if (mask == 0)
+                continue;
+
+            nb_changed++;
+            putVarint(changed, it.first);
+            putVarint(changed, mask);
+            for (int i = 0; i < NB_RECORD_FIELDS; i++)
+                if (mask & (1ULL << i))
+                    putVarint(changed, zigzag(diffs[i]));
+            if (mask & (1ULL << NAME_BIT))
+                putString(changed, new_entry.name);
+            if (mask & (1ULL << EXE_BIT))
+                putString(changed, new_entry.exe);
+            if (mask & (1ULL << CMDLINE_BIT))
+                putString(changed, new_entry.cmdline);
+        }
+        putVarint(m_payload, nb_changed);
+        m_payload.append(changed);
+        m_since_keyframe++;
+    }
+
+    m_previous.swap(current);
+    writeFrame(keyframe ? FRAME_KEY : FRAME_DELTA, time);
+}
+
+void DeltaEncoder::forceKeyframe()
+{
+    m_need_keyframe = true;
+}
+
+size_t DeltaEncoder::lastFrameSize() const
+{
+    return m_frame.size();
+}
+
+void DeltaEncoder::writeFrame(enum frame_type type, std::chrono::system_clock::time_point time)
+{
+    struct frame_header_t header;
+    header.magic = FRAME_MAGIC;
+    header.type = type;
+    header.payload_size = m_payload.size();
+    header.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+
+    m_frame.assign(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_frame.append(m_payload);
+
+    // a pipe can take the frame in several writes
+    size_t offset = 0;
+    while (offset < m_frame.size())
+    {
+        ssize_t written = ::write(m_fd, m_frame.data() + offset, m_frame.size() - offset);
+        if (written == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            // the reader cannot apply the next deltas
+            m_need_keyframe = true;
+            throw std::string(strerror(errno));
+        }
+        offset += written;
+    }
+}
+
+DeltaDecoder::DeltaDecoder(int fd)
+    : m_fd(fd), m_has_keyframe(false)
+{
+}
+
+bool DeltaDecoder::next(std::vector<struct process_record_t>& records, StringTable& strings,
+                        std::chrono::system_clock::time_point& time)
+{
+    struct frame_header_t header;
+    while (true)
+    {
+        if (!readFully(reinterpret_cast<char*>(&header), sizeof(header)))
+            return false;
+        if (header.magic != FRAME_MAGIC)
+            throw std::string("corrupted delta stream");
+        m_payload.resize(header.payload_size);
+        if (!readFully(&m_payload[0], header.payload_size))
+            return false;
+        if (header.type == FRAME_KEY || m_has_keyframe)
+            break;
+    }
+
+    struct cursor_t cursor = {m_payload.data(), m_payload.data() + m_payload.size()};
+    if (header.type == FRAME_KEY)
+    {
+        m_state.clear();
+        uint64_t count = cursor.varint();
+        for (uint64_t i = 0; i < count; i++)
+        {
+            struct DeltaEncoder::entry_t entry;
+            cursor.entry(entry);
+            m_state[entry.record.pid] = std::move(entry);
+        }
+        m_has_keyframe = true;
+    }
+    else if (header.type == FRAME_DELTA)
+    {
+        uint64_t nb_removed = cursor.varint();
+        for (uint64_t i = 0; i < nb_removed; i++)
+            m_state.erase(cursor.varint());
+
+        uint64_t nb_added = cursor.varint();
+        for (uint64_t i = 0; i < nb_added; i++)
+        {
+            struct DeltaEncoder::entry_t entry;
+            cursor.entry(entry);
+            m_state[entry.record.pid] = std::move(entry);
+        }
+
+        uint64_t nb_changed = cursor.varint();
+        for (uint64_t i = 0; i < nb_changed; i++)
+        {
+            std::map<pid_t, struct DeltaEncoder::entry_t>::iterator it = m_state.find(cursor.varint());
+            if (it == m_state.end())
+                throw std::string("corrupted delta stream");
+            struct DeltaEncoder::entry_t& entry = it->second;
+            uint64_t mask = cursor.varint();
+            for (int j = 0; j < NB_RECORD_FIELDS; j++)
+                if (mask & (1ULL << j))
+                    store(entry.record, RECORD_FIELDS[j],
+                          load(entry.record, RECORD_FIELDS[j]) + unzigzag(cursor.varint()));
+            if (mask & (1ULL << NAME_BIT))
+                entry.name = cursor.string();
+            if (mask & (1ULL << EXE_BIT))
+                entry.exe = cursor.string();
+            if (mask & (1ULL << CMDLINE_BIT))
+                entry.cmdline = cursor.string();
+        }
+    }
+    else
+    {
+        throw std::string("unknown delta frame type");
+    }
+
+    records.clear();
+    records.reserve(m_state.size());
+    strings.clear();
+    for (std::pair<const pid_t, struct DeltaEncoder::entry_t>& it : m_state)
+    {
+        records.push_back(it.second.record);
+        struct process_record_t& record = records.back();
+        record.name = strings.add(it.second.name);
+        record.exe = strings.add(it.second.exe);
+        record.cmdline = strings.add(it.second.cmdline);
+    }
+    time = std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                std::chrono::nanoseconds(header.timestamp)));
+    return true;
+}
+
+bool DeltaDecoder::readFully(char* buf, size_t size)
+{
+    size_t offset = 0;
+    while (offset < size)
+    {
+        ssize_t nread = read(m_fd, buf + offset, size - offset);
+        if (nread == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            throw std::string(strerror(errno));
+        }
+        if (nread == 0)
+            return false;
+        offset += nread;
+    }
+    return true;
+}
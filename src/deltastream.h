@@ -0,0 +1,90 @@
+#ifndef DELTASTREAM_H
+#define DELTASTREAM_H
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "snapshot.h"
+
+enum frame_type
+{
+    // every process, resets the decoder state
+    FRAME_KEY = 1,
+    // removed, added and changed processes since the previous frame
+    FRAME_DELTA = 2
+};
+
+// Writes successive process table snapshots to a file descriptor
+//
+// Each frame is a small header followed by a payload of varints: a
+// keyframe holds every record, a delta frame the pids which disappeared,
+// the new records and, for the others, a bitmask of the changed fields
+// followed by the zig-zag difference of each numeric field or the new
+// string. A keyframe is sent every keyframe_interval frames so that a
+// reader can join the stream, or recover, without the whole history.
+class DeltaEncoder
+{
+public:
+    DeltaEncoder(int fd, unsigned int keyframe_interval = 60);
+
+    void write(std::vector<ProcessInfo>& processes,
+               std::chrono::system_clock::time_point time = std::chrono::system_clock::now());
+    void write(const std::vector<struct process_record_t>& records, const StringTable& strings,
+               std::chrono::system_clock::time_point time);
+    // the next frame will be a keyframe
+    void forceKeyframe();
+
+    // bytes written by the last write()
+    size_t lastFrameSize() const;
+
+    // state of one process, strings resolved out of the table
+    struct entry_t
+    {
+        struct process_record_t record;
+        std::string name;
+        std::string exe;
+        std::string cmdline;
+    };
+
+private:
+    void writeFrame(enum frame_type type, std::chrono::system_clock::time_point time);
+
+    int m_fd;
+    unsigned int m_keyframe_interval;
+    unsigned int m_since_keyframe;
+    bool m_need_keyframe;
+    std::map<pid_t, struct entry_t> m_previous;
+    std::string m_payload;
+    std::string m_frame;
+    // reused by write(processes)
+    std::vector<struct process_record_t> m_records;
+    StringTable m_strings;
+};
+
+// Rebuilds the snapshots written by a DeltaEncoder
+class DeltaDecoder
+{
+public:
+    DeltaDecoder(int fd);
+
+    // read the next frame, false at the end of the stream
+    // the delta frames before the first keyframe are skipped
+    // records are sorted by pid, their strings refer to strings
+    bool next(std::vector<struct process_record_t>& records, StringTable& strings,
+              std::chrono::system_clock::time_point& time);
+
+private:
+    bool readFully(char* buf, size_t size);
+
+    int m_fd;
+    bool m_has_keyframe;
+    std::map<pid_t, struct DeltaEncoder::entry_t> m_state;
+    std::string m_payload;
+};
+
+#endif // DELTASTREAM_H
@@ -0,0 +1,300 @@
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+
+#include <unistd.h>
+
+#include "exporter.h"
+
+namespace {
+
+const char HEX_DIGITS[] = "0123456789abcdef";
+
+// length of the well formed UTF-8 sequence at str, 0 if it is not one
+// (stray continuation byte, overlong form, surrogate, above U+10FFFF)
+size_t utf8Length(const unsigned char* str, size_t size)
+{
+    unsigned char c = str[0];
+    size_t len;
+    unsigned char low = 0x80;
+    unsigned char high = 0xbf;
+    if (c >= 0xc2 && c <= 0xdf)
+        len = 2;
+    else if (c >= 0xe0 && c <= 0xef)
+    {
+        len = 3;
+        if (c == 0xe0)
+            low = 0xa0;
+        else if (c == 0xed)
+            high = 0x9f;
+    }
+    else if (c >= 0xf0 && c <= 0xf4)
+    {
+        len = 4;
+        if (c == 0xf0)
+            low = 0x90;
+        else if (c == 0xf4)
+            high = 0x8f;
+    }
+    else
+        return 0;
+    if (len > size || str[1] < low || str[1] > high)
+        return 0;
+    for (size_t i = 2; i < len; i++)
+        if (str[i] < 0x80 || str[i] > 0xbf)
+            return 0;
+    return len;
+}
+
+// a Prometheus metric family read from the records
+struct metric_family_t
+{
+    const char* name;
+    const char* type;
+    const char* help;
+    long long (*value)(const struct process_record_t& record);
+};
+
+const struct metric_family_t METRIC_FAMILIES[] = {
+    {"process_cpu_user_ticks_total", "counter", "Time scheduled in user mode, in clock ticks.",
+     [](const struct process_record_t& r) -> long long { return r.utime; }},
+    {"process_cpu_system_ticks_total", "counter", "Time scheduled in kernel mode, in clock ticks.",
+     [](const struct process_record_t& r) -> long long { return r.stime; }},
+    {"process_cpu_usage_percent", "gauge", "CPU usage since the previous sample.",
+     [](const struct process_record_t& r) -> long long { return r.cpu_usage; }},
+    {"process_virtual_memory_bytes", "gauge", "Virtual memory size in bytes.",
+     [](const struct process_record_t& r) -> long long { return r.vm_size; }},
+    {"process_resident_memory_bytes", "gauge", "Resident set size in bytes.",
+     [](const struct process_record_t& r) -> long long { return r.vm_rss * 1024; }},
+    {"process_swap_bytes", "gauge", "Swapped out memory in bytes.",
+     [](const struct process_record_t& r) -> long long { return r.vm_swap * 1024; }},
+    {"process_minor_faults_total", "counter", "Minor page faults.",
+     [](const struct process_record_t& r) -> long long { return r.minflt; }},
+    {"process_major_faults_total", "counter", "Major page faults.",
+     [](const struct process_record_t& r) -> long long { return r.majflt; }},
+    {"process_read_bytes_total", "counter", "Bytes read from the storage layer.",
+     [](const struct process_record_t& r) -> long long { return r.read_bytes; }},
+    {"process_written_bytes_total", "counter", "Bytes written to the storage layer.",
+     [](const struct process_record_t& r) -> long long { return r.write_bytes; }},
+    {"process_threads", "gauge", "Number of threads.",
+     [](const struct process_record_t& r) -> long long { return r.num_threads; }},
+    {"process_nice", "gauge", "Nice value.",
+     [](const struct process_record_t& r) -> long long { return r.nice; }},
+};
+
+} // namespace
+
+OutputBuffer::OutputBuffer(size_t capacity)
+    : m_data(capacity == 0 ? 1 : capacity), m_size(0)
+{
+}
+
+char* OutputBuffer::reserve(size_t size)
+{
+    if (m_size + size > m_data.size())
+        m_data.resize(std::max(m_data.size() * 2, m_size + size));
+    return m_data.data() + m_size;
+}
+
+void OutputBuffer::append(boost::string_view str)
+{
+    memcpy(reserve(str.size()), str.data(), str.size());
+    m_size += str.size();
+}
+
+void OutputBuffer::append(char c)
+{
+    *reserve(1) = c;
+    m_size++;
+}
+
+void OutputBuffer::appendInt(long long value)
+{
+    // 20 digits and the sign
+    char* begin = reserve(21);
+    m_size = std::to_chars(begin, begin + 21, value).ptr - m_data.data();
+}
+
+void OutputBuffer::appendUInt(unsigned long long value)
+{
+    char* begin = reserve(20);
+    m_size = std::to_chars(begin, begin + 20, value).ptr - m_data.data();
+}
+
+void OutputBuffer::appendJsonEscaped(boost::string_view str)
+{
+    // copy the runs of characters which do not need escaping at once
+    size_t run = 0;
+    for (size_t i = 0; i < str.size(); i++)
+    {
+        unsigned char c = str[i];
+        if (c >= 0x80)
+        {
+            // cmdline and comm are arbitrary bytes, keep the line valid UTF-8
+            size_t len = utf8Length(reinterpret_cast<const unsigned char*>(str.data()) + i, str.size() - i);
+            if (len != 0)
+            {
+                i += len - 1;
+                continue;
+            }
+        }
+        else if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+        append(str.substr(run, i - run));
+        run = i + 1;
+        if (c >= 0x80)
+            append("\\ufffd");
+        else if (c == '"')
+            append("\\\"");
+        else if (c == '\\')
+            append("\\\\");
+        else if (c == '\n')
+            append("\\n");
+        else if (c == '\t')
+            append("\\t");
+        else
+        {
+            append("\\u00");
+            append(HEX_DIGITS[c >> 4]);
+            append(HEX_DIGITS[c & 0xf]);
+        }
+    }
+    append(str.substr(run));
+}
+
+void OutputBuffer::appendLabelEscaped(boost::string_view str)
+{
+    size_t run = 0;
+    for (size_t i = 0; i < str.size(); i++)
+    {
+        char c = str[i];
+        if (c != '\\' && c != '"' && c != '\n')
+            continue;
+        append(str.substr(run, i - run));
+        run = i + 1;
+        if (c == '\\')
+            append("\\\\");
+        else if (c == '"')
+            append("\\\"");
+        else
+            append("\\n");
+    }
+    append(str.substr(run));
+}
+
+const char* OutputBuffer::data() const
+{
+    return m_data.data();
+}
+
+size_t OutputBuffer::size() const
+{
+    return m_size;
+}
+
+void OutputBuffer::clear()
+{
+    m_size = 0;
+}
+
+void OutputBuffer::flush(int fd)
+{
+    size_t offset = 0;
+    while (offset < m_size)
+    {
+        ssize_t written = write(fd, m_data.data() + offset, m_size - offset);
+        if (written == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            throw std::string(strerror(errno));
+        }
+        offset += written;
+    }
+    m_size = 0;
+}
+
+void exportNdjson(const struct snapshot_view_t& snapshot, OutputBuffer& out)
+{
+    // milliseconds since epoch
+    long long timestamp = snapshot.timestamp.count() / 1000000;
+    for (size_t i = 0; i < snapshot.count; i++)
+    {
+        const struct process_record_t& r = snapshot.records[i];
+        out.append("{\"timestamp\":");
+        out.appendInt(timestamp);
+        out.append(",\"pid\":");
+        out.appendInt(r.pid);
+        out.append(",\"ppid\":");
+        out.appendInt(r.ppid);
+        out.append(",\"name\":\"");
+        out.appendJsonEscaped(snapshot.string(r.name));
+        out.append("\",\"state\":\"");
+        out.appendJsonEscaped(boost::string_view(&r.state, 1));
+        out.append("\",\"uid\":");
+        out.appendUInt(r.uid);
+        out.append(",\"gid\":");
+        out.appendUInt(r.gid);
+        out.append(",\"nice\":");
+        out.appendInt(r.nice);
+        out.append(",\"num_threads\":");
+        out.appendUInt(r.num_threads);
+        out.append(",\"utime\":");
+        out.appendUInt(r.utime);
+        out.append(",\"stime\":");
+        out.appendUInt(r.stime);
+        out.append(",\"cpu_usage\":");
+        out.appendInt(r.cpu_usage);
+        out.append(",\"starttime\":");
+        out.appendUInt(r.starttime);
+        out.append(",\"vm_size\":");
+        out.appendUInt(r.vm_size);
+        out.append(",\"vm_rss\":");
+        out.appendUInt(r.vm_rss);
+        out.append(",\"vm_swap\":");
+        out.appendUInt(r.vm_swap);
+        out.append(",\"minflt\":");
+        out.appendUInt(r.minflt);
+        out.append(",\"majflt\":");
+        out.appendUInt(r.majflt);
+        out.append(",\"read_bytes\":");
+        out.appendUInt(r.read_bytes);
+        out.append(",\"write_bytes\":");
+        out.appendUInt(r.write_bytes);
+        out.append(",\"exe\":\"");
+        out.appendJsonEscaped(snapshot.string(r.exe));
+        out.append("\",\"cmdline\":\"");
+        out.appendJsonEscaped(snapshot.string(r.cmdline));
+        out.append("\"}\n");
+    }
+}
+
+void exportPrometheus(const struct snapshot_view_t& snapshot, OutputBuffer& out)
+{
+    // the samples of a family have to be grouped together
+    for (const struct metric_family_t& family : METRIC_FAMILIES)
+    {
+        out.append("# HELP ");
+        out.append(family.name);
+        out.append(' ');
+        out.append(family.help);
+        out.append("\n# TYPE ");
+        out.append(family.name);
+        out.append(' ');
+        out.append(family.type);
+        out.append('\n');
+        for (size_t i = 0; i < snapshot.count; i++)
+        {
+            const struct process_record_t& r = snapshot.records[i];
+            out.append(family.name);
+            out.append("{pid=\"");
+            out.appendInt(r.pid);
+            out.append("\",name=\"");
+            out.appendLabelEscaped(snapshot.string(r.name));
+            out.append("\"} ");
+            out.appendInt(family.value(r));
+            out.append('\n');
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include <cstddef>
+#include <vector>
+
+#include <boost/utility/string_view.hpp>
+
+#include "snapshot.h"
+
+// Growable text buffer reused between exports
+//
+// Numbers are formatted in place with std::to_chars, so once the buffer
+// has reached the size of a snapshot, exporting does not allocate.
+class OutputBuffer
+{
+public:
+    OutputBuffer(size_t capacity = 64 * 1024);
+
+    void append(boost::string_view str);
+    void append(char c);
+    void appendInt(long long value);
+    void appendUInt(unsigned long long value);
+    // JSON string content, without the quotes, invalid UTF-8 bytes are
+    // replaced by U+FFFD
+    void appendJsonEscaped(boost::string_view str);
+    // Prometheus label value, without the quotes
+    void appendLabelEscaped(boost::string_view str);
+
+    const char* data() const;
+    size_t size() const;
+    void clear();
+    // write the whole content to fd, then clear it
+    void flush(int fd);
+
+private:
+    // room for at least size more bytes at m_data + m_size
+    char* reserve(size_t size);
+
+    std::vector<char> m_data;
+    size_t m_size;
+};
+
+// one JSON object per process and per line
+void exportNdjson(const struct snapshot_view_t& snapshot, OutputBuffer& out);
+// text exposition format, one family per metric, labelled by pid and name
+void exportPrometheus(const struct snapshot_view_t& snapshot, OutputBuffer& out);
+
+#endif // EXPORTER_H
@@ -0,0 +1,123 @@
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "fdreader.h"
+#include "procfs.h"
+#include "procbackend.h"
+#include "instrumentation.h"
+
+FdReader::FdReader(const std::string& fd_dir_path)
+    : m_path(fd_dir_path), m_dir_fd(-1), m_live(procBackend().isLive()), m_listed(false)
+{
+    if (m_live)
+        m_dir_fd = open(fd_dir_path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    else
+        m_listed = procBackend().listDir(fd_dir_path, m_names);
+    if (!isOpen())
+        SourceProbe::read(-1, 0, probeError(fd_dir_path, errno));
+}
+
+FdReader::~FdReader()
+{
+    if (m_dir_fd != -1)
+        close(m_dir_fd);
+}
+
+bool FdReader::isOpen() const
+{
+    return m_live ? m_dir_fd != -1 : m_listed;
+}
+
+long FdReader::count()
+{
+    long total = 0;
+    iterate([&total](int, const char*) { total++; });
+    return total;
+}
+
+struct fd_count_t FdReader::classify()
+{
+    struct fd_count_t counts = fd_count_t();
+    forEach([&counts](int, const char* target, size_t len) {
+        tally(counts, typeOf(target, len));
+    });
+    return counts;
+}
+
+void FdReader::forEach(const std::function<void(int fd, const char* target, size_t len)>& callback)
+{
+    if (!m_live)
+    {
+        std::string target;
+        iterate([this, &target, &callback](int fd, const char* name) {
+            if (procBackend().readLink(m_path + "/" + name, target))
+                callback(fd, target.data(), target.size());
+        });
+        return;
+    }
+
+    char target[4096];
+    int dir_fd = m_dir_fd;
+    iterate([dir_fd, &target, &callback](int fd, const char* name) {
+        ssize_t len = readlinkat(dir_fd, name, target, sizeof(target));
+        if (len < 0)
+        {
+            if (errno == ENOENT)
+                return; // fd closed in the meantime
+            len = 0; // not allowed to resolve it, still report the fd
+        }
+        callback(fd, target, len);
+    });
+}
+
+enum fd_type FdReader::typeOf(const char* target, size_t len)
+{
+    // socket:[12345], pipe:[12345], anon_inode:[eventfd], /dev/null
+    if (len > 0 && target[0] == '/')
+        return FD_FILE;
+    if (len >= 7 && strncmp(target, "socket:", 7) == 0)
+        return FD_SOCKET;
+    if (len >= 5 && strncmp(target, "pipe:", 5) == 0)
+        return FD_PIPE;
+    if (len >= 11 && strncmp(target, "anon_inode:", 11) == 0)
+        return FD_ANON_INODE;
+    return FD_OTHER;
+}
+
+void FdReader::tally(struct fd_count_t& counts, enum fd_type type)
+{
+    counts.total++;
+    switch (type)
+    {
+    case FD_FILE:
+        counts.files++;
+        break;
+    case FD_SOCKET:
+        counts.sockets++;
+        break;
+    case FD_PIPE:
+        counts.pipes++;
+        break;
+    case FD_ANON_INODE:
+        counts.anon_inodes++;
+        break;
+    case FD_OTHER:
+        counts.others++;
+        break;
+    }
+}
+
+void FdReader::iterate(const std::function<void(int fd, const char* name)>& callback)
+{
+    if (m_live)
+    {
+        forEachNumericEntry(m_dir_fd, callback);
+        return;
+    }
+    for (const std::string& name : m_names)
+        if (!name.empty() && name.find_first_not_of("0123456789") == std::string::npos)
+            callback(std::stoi(name), name.c_str());
+}
@@ -0,0 +1,66 @@
+#ifndef FDREADER_H
+#define FDREADER_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+enum fd_type
+{
+    FD_FILE,
+    FD_SOCKET,
+    FD_PIPE,
+    FD_ANON_INODE,
+    FD_OTHER
+};
+
+struct fd_count_t
+{
+    long total;
+    long files;
+    long sockets;
+    long pipes;
+    long anon_inodes;
+    long others;
+};
+
+// Enumerates a /proc/<pid>/fd directory
+//
+// Entries are read in large batches with getdents64() and each link is
+// resolved with readlinkat() relative to the directory fd, into a stack
+// buffer. count() does not resolve the links at all and classify() only
+// looks at their prefix, so neither of them allocates per fd.
+// When procBackend() is not the live system, the directory and the links
+// are read through it instead.
+class FdReader
+{
+public:
+    FdReader(const std::string& fd_dir_path);
+    ~FdReader();
+
+    FdReader(const FdReader&) = delete;
+    FdReader& operator=(const FdReader&) = delete;
+
+    // false if the process is gone or the directory is not readable
+    bool isOpen() const;
+
+    long count();
+    struct fd_count_t classify();
+    // target is not null terminated
+    void forEach(const std::function<void(int fd, const char* target, size_t len)>& callback);
+
+    static enum fd_type typeOf(const char* target, size_t len);
+    static void tally(struct fd_count_t& counts, enum fd_type type);
+
+private:
+    void iterate(const std::function<void(int fd, const char* name)>& callback);
+
+    std::string m_path;
+    int m_dir_fd;
+    // through procBackend()
+    bool m_live;
+    bool m_listed;
+    std::vector<std::string> m_names;
+};
+
+#endif // FDREADER_H
@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "historystore.h"
+#include "processinfo.h"
+
+HistoryStore::HistoryStore(size_t capacity, unsigned int metrics)
+    : m_capacity(capacity == 0 ? 1 : capacity),
+      m_metrics(metrics & METRIC_ALL),
+      m_nb_columns(0),
+      m_generation(0)
+{
+    for (int metric = 0; metric < METRIC_COUNT; metric++)
+        m_column[metric] = (m_metrics & (1 << metric)) ? m_nb_columns++ : -1;
+}
+
+void HistoryStore::record(ProcessInfo& pinfo, clock::time_point time)
+{
+    // only the files of the selected metrics are read
+    double values[METRIC_COUNT] = {};
+    if (m_metrics & (1 << METRIC_CPU_USAGE))
+        values[METRIC_CPU_USAGE] = pinfo.cpuUsage();
+    if (m_metrics & (1 << METRIC_VM_RSS))
+        values[METRIC_VM_RSS] = pinfo.vmRss();
+    if (m_metrics & (1 << METRIC_READ_BYTES))
+        values[METRIC_READ_BYTES] = pinfo.readBytes();
+    if (m_metrics & (1 << METRIC_WRITE_BYTES))
+        values[METRIC_WRITE_BYTES] = pinfo.writeBytes();
+    if (m_metrics & (1 << METRIC_MINFLT))
+        values[METRIC_MINFLT] = pinfo.minflt();
+    if (m_metrics & (1 << METRIC_MAJFLT))
+        values[METRIC_MAJFLT] = pinfo.majflt();
+    append(pinfo.pid(), pinfo.startTicks(), time, values);
+}
+
+void HistoryStore::record(std::vector<ProcessInfo>& processes, clock::time_point time)
+{
+    m_generation++;
+    for (ProcessInfo& pinfo : processes)
+        record(pinfo, time);
+
+    // the processes which exited
+    std::unordered_map<pid_t, struct ring_t>::iterator it = m_rings.begin();
+    while (it != m_rings.end())
+    {
+        if (it->second.generation != m_generation)
+            it = m_rings.erase(it);
+        else
+            ++it;
+    }
+}
+
+void HistoryStore::append(pid_t pid, unsigned long long start_ticks, clock::time_point time,
+                          const double values[METRIC_COUNT])
+{
+    struct ring_t& ring = m_rings[pid];
+    if (ring.times.empty())
+    {
+        // allocated once, appending never allocates afterwards
+        ring.start_ticks = start_ticks;
+        ring.head = 0;
+        ring.count = 0;
+        ring.times.resize(m_capacity);
+        ring.values.resize(m_capacity * m_nb_columns);
+    }
+    else if (ring.start_ticks != start_ticks)
+    {
+        // pid reused, the samples belong to the dead process
+        ring.start_ticks = start_ticks;
+        ring.head = 0;
+        ring.count = 0;
+    }
+    ring.generation = m_generation;
+
+    ring.times[ring.head] = time;
+    for (int metric = 0; metric < METRIC_COUNT; metric++)
+        if (m_column[metric] != -1)
+            ring.values[m_column[metric] * m_capacity + ring.head] = values[metric];
+
+    ring.head = (ring.head + 1) % m_capacity;
+    if (ring.count < m_capacity)
+        ring.count++;
+}
+
+const struct HistoryStore::ring_t* HistoryStore::find(pid_t pid, enum history_metric metric) const
+{
+    if (metric < 0 || metric >= METRIC_COUNT || m_column[metric] == -1)
+        return nullptr;
+    std::unordered_map<pid_t, struct ring_t>::const_iterator it = m_rings.find(pid);
+    if (it == m_rings.end() || it->second.count == 0)
+        return nullptr;
+    return &it->second;
+}
+
+template <typename Callback>
+void HistoryStore::scan(const struct ring_t& ring, enum history_metric metric,
+                        clock::time_point since, Callback callback) const
+{
+    const double* column = ring.values.data() + m_column[metric] * m_capacity;
+    size_t index = ring.head;
+    for (size_t i = 0; i < ring.count; i++)
+    {
+        index = (index == 0 ? m_capacity : index) - 1;
+        // samples are appended in time order
+        if (ring.times[index] < since)
+            break;
+        callback(column[index]);
+    }
+}
+
+struct window_stat_t HistoryStore::stats(pid_t pid, enum history_metric metric,
+                                         std::chrono::milliseconds window, clock::time_point now) const
+{
+    struct window_stat_t stat = {0, 0, 0, 0};
+    const struct ring_t* ring = find(pid, metric);
+    if (ring == nullptr)
+        return stat;
+
+    double min = std::numeric_limits<double>::max();
+    double max = std::numeric_limits<double>::lowest();
+    double sum = 0;
+    size_t count = 0;
+    scan(*ring, metric, now - window, [&](double value) {
+        min = std::min(min, value);
+        max = std::max(max, value);
+        sum += value;
+        count++;
+    });
+    if (count == 0)
+        return stat;
+
+    stat.count = count;
+    stat.min = min;
+    stat.max = max;
+    stat.avg = sum / count;
+    return stat;
+}
+
+double HistoryStore::percentile(pid_t pid, enum history_metric metric, double p,
+                                std::chrono::milliseconds window, clock::time_point now) const
+{
+    const struct ring_t* ring = find(pid, metric);
+    if (ring == nullptr)
+        return 0;
+
+    m_scratch.clear();
+    scan(*ring, metric, now - window, [this](double value) {
+        m_scratch.push_back(value);
+    });
+    if (m_scratch.empty())
+        return 0;
+
+    p = std::min(std::max(p, 0.0), 100.0);
+    size_t rank = static_cast<size_t>(std::ceil(p / 100 * m_scratch.size()));
+    size_t nth = rank == 0 ? 0 : rank - 1;
+    std::nth_element(m_scratch.begin(), m_scratch.begin() + nth, m_scratch.end());
+    return m_scratch[nth];
+}
+
+double HistoryStore::last(pid_t pid, enum history_metric metric) const
+{
+    const struct ring_t* ring = find(pid, metric);
+    if (ring == nullptr)
+        return 0;
+    size_t index = (ring->head == 0 ? m_capacity : ring->head) - 1;
+    return ring->values[m_column[metric] * m_capacity + index];
+}
+
+size_t HistoryStore::count(pid_t pid) const
+{
+    std::unordered_map<pid_t, struct ring_t>::const_iterator it = m_rings.find(pid);
+    return it == m_rings.end() ? 0 : it->second.count;
+}
+
+void HistoryStore::erase(pid_t pid)
+{
+    m_rings.erase(pid);
+}
+
+void HistoryStore::clear()
+{
+    m_rings.clear();
+}
+
+size_t HistoryStore::size() const
+{
+    return m_rings.size();
+}
+
+size_t HistoryStore::capacity() const
+{
+    return m_capacity;
+}
+
+unsigned int HistoryStore::metrics() const
+{
+    return m_metrics;
+}
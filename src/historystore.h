@@ -0,0 +1,111 @@
+#ifndef HISTORYSTORE_H
+#define HISTORYSTORE_H
+
+#include <chrono>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/types.h>
+
+class ProcessInfo;
+
+// numeric values kept by a HistoryStore
+enum history_metric
+{
+    METRIC_CPU_USAGE,
+    // kB
+    METRIC_VM_RSS,
+    METRIC_READ_BYTES,
+    METRIC_WRITE_BYTES,
+    METRIC_MINFLT,
+    METRIC_MAJFLT,
+    METRIC_COUNT
+};
+#define METRIC_ALL ((1 << METRIC_COUNT) - 1)
+
+struct window_stat_t
+{
+    // number of samples in the window, the other fields are 0 without any
+    size_t count;
+    double min;
+    double max;
+    double avg;
+};
+
+// Keeps the last samples of a few metrics for each process
+//
+// Each process owns a circular buffer allocated once with room for
+// capacity samples: one timestamp column and one column per selected
+// metric. Appending overwrites the oldest sample, and the window queries
+// only scan the samples younger than the window. A ring belongs to one
+// process, identified by its pid and start time: a reused pid starts a
+// new ring instead of inheriting the samples of the dead process.
+class HistoryStore
+{
+public:
+    typedef std::chrono::steady_clock clock;
+
+    // metrics is a mask of 1 << history_metric
+    HistoryStore(size_t capacity, unsigned int metrics = METRIC_ALL);
+
+    // read the selected metrics of the process and append them
+    void record(ProcessInfo& pinfo, clock::time_point time = clock::now());
+    // processes is the whole process table, the processes missing from it
+    // are dropped
+    void record(std::vector<ProcessInfo>& processes, clock::time_point time = clock::now());
+    // values is indexed by history_metric, unselected metrics are ignored
+    // start_ticks is the start time of the process, see startTicks()
+    void append(pid_t pid, unsigned long long start_ticks, clock::time_point time,
+                const double values[METRIC_COUNT]);
+
+    // samples taken less than window before now
+    struct window_stat_t stats(pid_t pid, enum history_metric metric,
+                               std::chrono::milliseconds window, clock::time_point now = clock::now()) const;
+    // p between 0 and 100, nearest rank, 0 without any sample
+    double percentile(pid_t pid, enum history_metric metric, double p,
+                      std::chrono::milliseconds window, clock::time_point now = clock::now()) const;
+    // most recent value, 0 without any sample
+    double last(pid_t pid, enum history_metric metric) const;
+    // number of samples kept for the process
+    size_t count(pid_t pid) const;
+
+    void erase(pid_t pid);
+    void clear();
+    // number of processes
+    size_t size() const;
+    size_t capacity() const;
+    unsigned int metrics() const;
+
+private:
+    struct ring_t
+    {
+        unsigned long long start_ticks;
+        // record() call which appended the last sample
+        unsigned long generation;
+        // index of the next sample
+        size_t head;
+        size_t count;
+        std::vector<clock::time_point> times;
+        // one column of capacity values per selected metric, back to back
+        std::vector<double> values;
+    };
+
+    const struct ring_t* find(pid_t pid, enum history_metric metric) const;
+    // calls callback(value) on the samples of the window, newest first
+    template <typename Callback>
+    void scan(const struct ring_t& ring, enum history_metric metric,
+              clock::time_point since, Callback callback) const;
+
+    size_t m_capacity;
+    unsigned int m_metrics;
+    // history_metric -> column in ring_t::values, -1 if not selected
+    int m_column[METRIC_COUNT];
+    int m_nb_columns;
+    // incremented by each record() of a process table
+    unsigned long m_generation;
+    std::unordered_map<pid_t, struct ring_t> m_rings;
+    // reused by percentile()
+    mutable std::vector<double> m_scratch;
+};
+
+#endif // HISTORYSTORE_H
@@ -0,0 +1,163 @@
+#include <atomic>
+#include <cerrno>
+#include <ctime>
+
+#include "instrumentation.h"
+
+namespace {
+
+struct source_counters_t
+{
+    std::atomic<unsigned long> calls;
+    std::atomic<unsigned long> vanished;
+    std::atomic<unsigned long> denied;
+    std::atomic<unsigned long> failures;
+    std::atomic<unsigned long> bytes;
+    std::atomic<unsigned long long> read_ns;
+    std::atomic<unsigned long long> parse_ns;
+    std::atomic<unsigned long> latency[LATENCY_BUCKETS];
+};
+
+std::atomic<bool> s_enabled(false);
+struct source_counters_t s_counters[SOURCE_COUNT];
+thread_local SourceProbe* t_current = nullptr;
+
+const char* const SOURCE_NAMES[SOURCE_COUNT] = {
+    "stat", "status", "io", "cmdline", "cwd", "exe", "root", "environ", "fd", "wchan", "smaps",
+    "cgroup", "limits", "stack", "cpu_stat", "cpuinfo", "net_tcp", "net_unix", "tty_scan",
+    "user_name", "group_name"
+};
+
+unsigned long long nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<unsigned long long>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+int latencyBucket(unsigned long long ns)
+{
+    if (ns == 0)
+        return 0;
+    int bucket = 63 - __builtin_clzll(ns);
+    return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+}
+
+} // namespace
+
+void setInstrumentation(bool enabled)
+{
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool instrumentationEnabled()
+{
+    return s_enabled.load(std::memory_order_relaxed);
+}
+
+struct source_stats_t sourceStats(enum data_source source)
+{
+    struct source_stats_t stats = source_stats_t();
+    if (source < 0 || source >= SOURCE_COUNT)
+        return stats;
+    const struct source_counters_t& counters = s_counters[source];
+    stats.calls = counters.calls.load(std::memory_order_relaxed);
+    stats.vanished = counters.vanished.load(std::memory_order_relaxed);
+    stats.denied = counters.denied.load(std::memory_order_relaxed);
+    stats.failures = counters.failures.load(std::memory_order_relaxed);
+    stats.bytes = counters.bytes.load(std::memory_order_relaxed);
+    stats.read_ns = counters.read_ns.load(std::memory_order_relaxed);
+    stats.parse_ns = counters.parse_ns.load(std::memory_order_relaxed);
+    for (int i = 0; i < LATENCY_BUCKETS; i++)
+        stats.latency[i] = counters.latency[i].load(std::memory_order_relaxed);
+    return stats;
+}
+
+const char* sourceName(enum data_source source)
+{
+    if (source < 0 || source >= SOURCE_COUNT)
+        return "";
+    return SOURCE_NAMES[source];
+}
+
+void resetSourceStats()
+{
+    for (struct source_counters_t& counters : s_counters)
+    {
+        counters.calls.store(0, std::memory_order_relaxed);
+        counters.vanished.store(0, std::memory_order_relaxed);
+        counters.denied.store(0, std::memory_order_relaxed);
+        counters.failures.store(0, std::memory_order_relaxed);
+        counters.bytes.store(0, std::memory_order_relaxed);
+        counters.read_ns.store(0, std::memory_order_relaxed);
+        counters.parse_ns.store(0, std::memory_order_relaxed);
+        for (std::atomic<unsigned long>& bucket : counters.latency)
+            bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+SourceProbe::SourceProbe(enum data_source source)
+    : m_source(source), m_enabled(instrumentationEnabled()), m_failed(false), m_error(0),
+      m_bytes(0), m_read_ns(0), m_start_ns(0), m_parent(nullptr)
+{
+    if (!m_enabled)
+        return;
+    m_parent = t_current;
+    t_current = this;
+    m_start_ns = nowNs();
+}
+
+SourceProbe::~SourceProbe()
+{
+    if (!m_enabled)
+        return;
+    unsigned long long total_ns = nowNs() - m_start_ns;
+    t_current = m_parent;
+
+    struct source_counters_t& counters = s_counters[m_source];
+    counters.calls.fetch_add(1, std::memory_order_relaxed);
+    if (m_failed)
+    {
+        if (m_error == ESRCH)
+            counters.vanished.fetch_add(1, std::memory_order_relaxed);
+        else if (m_error == EACCES || m_error == EPERM)
+            counters.denied.fetch_add(1, std::memory_order_relaxed);
+        else
+            counters.failures.fetch_add(1, std::memory_order_relaxed);
+    }
+    counters.bytes.fetch_add(m_bytes, std::memory_order_relaxed);
+    counters.read_ns.fetch_add(m_read_ns, std::memory_order_relaxed);
+    counters.parse_ns.fetch_add(total_ns > m_read_ns ? total_ns - m_read_ns : 0, std::memory_order_relaxed);
+    counters.latency[latencyBucket(total_ns)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void SourceProbe::failed()
+{
+    m_failed = true;
+}
+
+bool SourceProbe::active()
+{
+    return t_current != nullptr;
+}
+
+unsigned long long SourceProbe::now()
+{
+    return nowNs();
+}
+
+void SourceProbe::read(ssize_t bytes, unsigned long long ns, int error)
+{
+    SourceProbe* probe = t_current;
+    if (probe == nullptr)
+        return;
+    if (bytes < 0)
+    {
+        if (!probe->m_failed)
+            probe->m_error = error;
+        probe->m_failed = true;
+    }
+    else
+        probe->m_bytes += bytes;
+    probe->m_read_ns += ns;
+}
@@ -0,0 +1,100 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <sys/types.h>
+
+// data sources measured by the instrumentation, the first ones follow the
+// order of the field_group bits
+enum data_source
+{
+    SOURCE_STAT,
+    SOURCE_STATUS,
+    SOURCE_IO,
+    SOURCE_CMDLINE,
+    SOURCE_CWD,
+    SOURCE_EXE,
+    SOURCE_ROOT,
+    SOURCE_ENVIRON,
+    SOURCE_FD,
+    SOURCE_WCHAN,
+    SOURCE_SMAPS,
+    SOURCE_CGROUP,
+    SOURCE_LIMITS,
+    SOURCE_STACK,
+    // /proc/stat, for the cpu usage
+    SOURCE_CPU_STAT,
+    SOURCE_CPUINFO,
+    SOURCE_NET_TCP,
+    SOURCE_NET_UNIX,
+    // /dev walk of TtyIndex
+    SOURCE_TTY_SCAN,
+    // NSS or passwd / group lookups of UserCache, cache misses only
+    SOURCE_USER_NAME,
+    SOURCE_GROUP_NAME,
+    SOURCE_COUNT
+};
+
+// latency histogram, bucket i counts the calls between 2^i and 2^(i+1) ns
+#define LATENCY_BUCKETS 32
+
+struct source_stats_t
+{
+    unsigned long calls;
+    // the process exited before or while it was read
+    unsigned long vanished;
+    // EACCES / EPERM, environ or stack of another user without root
+    unsigned long denied;
+    // any other error, like the missing exe of a kernel thread
+    unsigned long failures;
+    unsigned long bytes;
+    // time spent reading, and the rest of the call
+    unsigned long long read_ns;
+    unsigned long long parse_ns;
+    unsigned long latency[LATENCY_BUCKETS];
+};
+
+// disabled by default, a disabled probe costs a relaxed atomic load
+void setInstrumentation(bool enabled);
+bool instrumentationEnabled();
+
+struct source_stats_t sourceStats(enum data_source source);
+const char* sourceName(enum data_source source);
+void resetSourceStats();
+
+// Measures one call to a data source, from construction to destruction
+//
+// The reads made on the same thread meanwhile report their size and
+// duration with SourceProbe::read(), which splits the time of the call
+// between reading and parsing. Probes can be nested, reads go to the
+// innermost one.
+class SourceProbe
+{
+public:
+    SourceProbe(enum data_source source);
+    ~SourceProbe();
+
+    SourceProbe(const SourceProbe&) = delete;
+    SourceProbe& operator=(const SourceProbe&) = delete;
+
+    void failed();
+
+    // true if a probe is measuring on this thread, to skip timing the reads
+    static bool active();
+    // bytes < 0 for a failed read, error is its errno, see probeError()
+    static void read(ssize_t bytes, unsigned long long ns, int error = 0);
+    // CLOCK_MONOTONIC in ns
+    static unsigned long long now();
+
+private:
+    enum data_source m_source;
+    bool m_enabled;
+    bool m_failed;
+    // errno of the first failed read
+    int m_error;
+    unsigned long m_bytes;
+    unsigned long long m_read_ns;
+    unsigned long long m_start_ns;
+    SourceProbe* m_parent;
+};
+
+#endif // INSTRUMENTATION_H
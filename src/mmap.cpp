@@ -5,7 +5,8 @@
 
 #include "mmap.h"
 
-MMap::MMap(std::stringstream& ss)
+MMap::MMap(std::stringstream& ss, StringArena& arena)
+    : m_arena(&arena), m_pathname(StringArena::empty)
 {
     std::string map_declaration;
     std::getline(ss, map_declaration);
@@ -27,7 +28,7 @@ MMap::MMap(std::stringstream& ss)
             m_dev_major = std::stoi(match[8], 0, 16);
             m_dev_minor = std::stoi(match[9], 0, 16);
             m_inode = std::stol(match[10]);
-            m_pathname = match[11];
+            m_pathname = arena.intern(boost::string_view(map_declaration).substr(match.position(11), match.length(11)));
         }
     }
     // parse attributes
@@ -112,32 +113,47 @@ const std::vector<std::string>& MMap::vmFlags() const
     return m_vmflags;
 }
 
-const std::string& MMap::path() const { return m_pathname; }
+boost::string_view MMap::path() const { return m_arena->view(m_pathname); }
 
 int MMap::size() const { return m_size; }
 
-const std::string& MMap::category() const
+int MMap::rss() const { return m_rss; }
+
+int MMap::pss() const { return m_pss; }
+
+int MMap::swap() const { return m_swap; }
+
+boost::string_view MMap::category() const
 {
-    return m_category;
+    static const char* const names[] = {
+        "Image",
+        "Heap",
+        "Stack",
+        "Shareable",
+        "Mapped File",
+        "Private"
+    };
+    return names[m_category];
 }
 
 // TODO check with ProcessInfo context
 void MMap::defineCategory()
 {
-    if (m_pathname.find("/usr/bin") != std::string::npos
-            || m_pathname.find("/usr/lib") != std::string::npos
-            || m_pathname == "[vsyscall]"
-            || m_pathname == "[vdso]"
-            || m_pathname == "[vvar]")
-        m_category = "Image";
-    else if (m_pathname.find("[heap]") != std::string::npos)
-        m_category = "Heap";
-    else if (m_pathname.find("[stack") != std::string::npos) // [stack] or [stack:tid]
-        m_category = "Stack";
+    boost::string_view pathname = path();
+    if (pathname.find("/usr/bin") != boost::string_view::npos
+            || pathname.find("/usr/lib") != boost::string_view::npos
+            || pathname == "[vsyscall]"
+            || pathname == "[vdso]"
+            || pathname == "[vvar]")
+        m_category = CATEGORY_IMAGE;
+    else if (pathname.find("[heap]") != boost::string_view::npos)
+        m_category = CATEGORY_HEAP;
+    else if (pathname.find("[stack") != boost::string_view::npos) // [stack] or [stack:tid]
+        m_category = CATEGORY_STACK;
     else if (m_type == shared)
-        m_category = "Shareable";
-    else if (!m_pathname.empty())
-        m_category = "Mapped File";
-    else if (m_pathname.empty())
-        m_category = "Private";
+        m_category = CATEGORY_SHAREABLE;
+    else if (!pathname.empty())
+        m_category = CATEGORY_MAPPED_FILE;
+    else
+        m_category = CATEGORY_PRIVATE;
 }
@@ -5,16 +5,29 @@
 #include <vector>
 #include <sstream>
 
+#include "stringarena.h"
+
 enum mapping_type
 {
     shared,
     priv
 };
 
+enum mapping_category
+{
+    CATEGORY_IMAGE,
+    CATEGORY_HEAP,
+    CATEGORY_STACK,
+    CATEGORY_SHAREABLE,
+    CATEGORY_MAPPED_FILE,
+    CATEGORY_PRIVATE
+};
+
 class MMap
 {
 public:
-    MMap(std::stringstream& ss);
+    // the pathname is interned in arena, which must outlive the mapping
+    MMap(std::stringstream& ss, StringArena& arena);
 
     // getters
     const std::string& addressFrom() const;
@@ -24,10 +37,14 @@ public:
     bool permExecute() const;
     const std::string permissions() const;
     const std::string type() const;
-    const std::string& path() const;
+    boost::string_view path() const;
     const std::vector<std::string>& vmFlags() const;
     int size() const;
-    const std::string& category() const;
+    // kB, from smaps
+    int rss() const;
+    int pss() const;
+    int swap() const;
+    boost::string_view category() const;
 
 private:
 
@@ -44,7 +61,8 @@ private:
     int m_dev_major;
     int m_dev_minor;
     long m_inode;
-    std::string m_pathname;
+    const StringArena* m_arena;
+    StringArena::handle_t m_pathname;
     // smaps additional fields
     int m_size;
     int m_rss;
@@ -61,7 +79,7 @@ private:
     int m_mmupagesize;
     int m_locked;
     std::vector<std::string> m_vmflags;
-    std::string m_category;
+    enum mapping_category m_category;
 
 
 };
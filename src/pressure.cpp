@@ -0,0 +1,191 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "pressure.h"
+#include "procbackend.h"
+#include "procfs.h"
+
+namespace {
+
+const char* const PRESSURE_NAMES[PRESSURE_RESOURCE_COUNT] = { "cpu", "memory", "io" };
+
+// value of "key=" in line, nullptr if missing
+const char* findValue(const char* line, const char* end, const char* key)
+{
+    size_t key_len = strlen(key);
+    for (const char* pos = line; pos + key_len <= end; pos++)
+    {
+        if (memcmp(pos, key, key_len) == 0)
+            return pos + key_len;
+    }
+    return nullptr;
+}
+
+void parseLine(const char* line, const char* end, struct pressure_line_t& pressure)
+{
+    const char* value;
+    if ((value = findValue(line, end, "avg10=")) != nullptr)
+        pressure.avg10 = strtof(value, nullptr);
+    if ((value = findValue(line, end, "avg60=")) != nullptr)
+        pressure.avg60 = strtof(value, nullptr);
+    if ((value = findValue(line, end, "avg300=")) != nullptr)
+        pressure.avg300 = strtof(value, nullptr);
+    if ((value = findValue(line, end, "total=")) != nullptr)
+        pressure.total = strtoull(value, nullptr, 10);
+}
+
+bool readPressureFile(ssize_t len, char* buf, struct pressure_t& pressure)
+{
+    if (len <= 0)
+        return false;
+    buf[len] = '\0';
+    return parsePressure(buf, len, pressure);
+}
+
+} // namespace
+
+const char* pressureName(enum pressure_resource resource)
+{
+    if (resource < 0 || resource >= PRESSURE_RESOURCE_COUNT)
+        return "";
+    return PRESSURE_NAMES[resource];
+}
+
+bool parsePressure(const char* buf, size_t len, struct pressure_t& pressure)
+{
+    pressure = pressure_t();
+    bool found = false;
+    const char* end = buf + len;
+    for (const char* line = buf; line < end;)
+    {
+        const char* line_end = static_cast<const char*>(memchr(line, '\n', end - line));
+        if (line_end == nullptr)
+            line_end = end;
+        if (line_end - line > 5 && memcmp(line, "some ", 5) == 0)
+        {
+            parseLine(line, line_end, pressure.some);
+            found = true;
+        }
+        else if (line_end - line > 5 && memcmp(line, "full ", 5) == 0)
+        {
+            parseLine(line, line_end, pressure.full);
+        }
+        line = line_end + 1;
+    }
+    return found;
+}
+
+bool readPressure(enum pressure_resource resource, struct pressure_t& pressure)
+{
+    // strtof needs a terminated buffer
+    char buf[256];
+    ssize_t len = readProcFile(procPath(std::string("pressure/") + pressureName(resource)), buf, sizeof(buf) - 1);
+    return readPressureFile(len, buf, pressure);
+}
+
+bool readCgroupPressure(const std::string& cgroup, enum pressure_resource resource, struct pressure_t& pressure)
+{
+    char buf[256];
+    std::string path = cgroupRoot() + (cgroup == "/" ? std::string() : cgroup) + "/" + pressureName(resource)
+            + ".pressure";
+    ssize_t len = readFileAt(AT_FDCWD, path.c_str(), buf, sizeof(buf) - 1);
+    return readPressureFile(len, buf, pressure);
+}
+
+PressureMonitor::PressureMonitor()
+    : m_next_id(0)
+{
+}
+
+PressureMonitor::~PressureMonitor()
+{
+    for (struct trigger_t& trigger : m_triggers)
+        close(trigger.fd);
+}
+
+int PressureMonitor::addTrigger(enum pressure_resource resource, bool full,
+                                std::chrono::microseconds stall, std::chrono::microseconds window)
+{
+    return add(procPath(std::string("pressure/") + pressureName(resource)), full, stall, window);
+}
+
+int PressureMonitor::addCgroupTrigger(const std::string& cgroup, enum pressure_resource resource, bool full,
+                                      std::chrono::microseconds stall, std::chrono::microseconds window)
+{
+    std::string path = cgroupRoot() + (cgroup == "/" ? std::string() : cgroup) + "/" + pressureName(resource)
+            + ".pressure";
+    return add(path, full, stall, window);
+}
+
+int PressureMonitor::add(const std::string& path, bool full,
+                         std::chrono::microseconds stall, std::chrono::microseconds window)
+{
+    int fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd == -1)
+        throw std::string(strerror(errno));
+    // the trigger lives as long as the fd
+    std::string threshold = std::string(full ? "full " : "some ") + std::to_string(stall.count()) + " "
+            + std::to_string(window.count());
+    if (write(fd, threshold.c_str(), threshold.size() + 1) < 0)
+    {
+        int error = errno;
+        close(fd);
+        throw std::string(strerror(error));
+    }
+    struct trigger_t trigger;
+    trigger.id = m_next_id++;
+    trigger.fd = fd;
+    m_triggers.push_back(trigger);
+    return trigger.id;
+}
+
+void PressureMonitor::removeTrigger(int id)
+{
+    for (std::vector<struct trigger_t>::iterator it = m_triggers.begin(); it != m_triggers.end(); ++it)
+    {
+        if (it->id == id)
+        {
+            close(it->fd);
+            m_triggers.erase(it);
+            return;
+        }
+    }
+}
+
+std::vector<int> PressureMonitor::wait(std::chrono::milliseconds timeout)
+{
+    std::vector<int> fired;
+    std::vector<struct pollfd> fds(m_triggers.size());
+    for (size_t i = 0; i < m_triggers.size(); i++)
+    {
+        fds[i].fd = m_triggers[i].fd;
+        fds[i].events = POLLPRI;
+        fds[i].revents = 0;
+    }
+    int ret = poll(fds.data(), fds.size(), timeout.count() < 0 ? -1 : timeout.count());
+    if (ret < 0)
+    {
+        if (errno == EINTR)
+            return fired;
+        throw std::string(strerror(errno));
+    }
+
+    std::vector<int> removed;
+    for (size_t i = 0; i < fds.size(); i++)
+    {
+        if (fds[i].revents == 0)
+            continue;
+        fired.push_back(m_triggers[i].id);
+        // POLLERR once the pressure file is gone
+        if (fds[i].revents & (POLLERR | POLLNVAL))
+            removed.push_back(m_triggers[i].id);
+    }
+    for (int id : removed)
+        removeTrigger(id);
+    return fired;
+}
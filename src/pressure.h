@@ -0,0 +1,88 @@
+#ifndef PRESSURE_H
+#define PRESSURE_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+enum pressure_resource
+{
+    PRESSURE_CPU,
+    PRESSURE_MEMORY,
+    PRESSURE_IO,
+    PRESSURE_RESOURCE_COUNT
+};
+
+// one line of a pressure file
+struct pressure_line_t
+{
+    // % of the time stalled over the last 10, 60 and 300 s
+    float avg10;
+    float avg60;
+    float avg300;
+    // total stall time, in microseconds
+    unsigned long long total;
+};
+
+struct pressure_t
+{
+    // some tasks stalled
+    struct pressure_line_t some;
+    // all the non idle tasks stalled, zero for the cpu of the system
+    struct pressure_line_t full;
+};
+
+// "cpu", "memory" or "io"
+const char* pressureName(enum pressure_resource resource);
+
+// Pressure Stall Information of the system, from procPath("pressure/...")
+// false if the kernel has no PSI
+bool readPressure(enum pressure_resource resource, struct pressure_t& pressure);
+// of a cgroup v2, path relative to cgroupRoot()
+bool readCgroupPressure(const std::string& cgroup, enum pressure_resource resource, struct pressure_t& pressure);
+bool parsePressure(const char* buf, size_t len, struct pressure_t& pressure);
+
+// Waits for PSI triggers instead of polling the averages
+//
+// Each trigger is a pressure file kept open with a "some|full stall window"
+// threshold written into it, the kernel wakes up poll() with POLLPRI when
+// the tasks stalled longer than stall within window. The window must be
+// between 500 ms and 10 s, and a multiple of 2 s without CAP_SYS_RESOURCE.
+class PressureMonitor
+{
+public:
+    PressureMonitor();
+    ~PressureMonitor();
+
+    PressureMonitor(const PressureMonitor&) = delete;
+    PressureMonitor& operator=(const PressureMonitor&) = delete;
+
+    // returns the trigger id, throws if the kernel refuses the trigger
+    int addTrigger(enum pressure_resource resource, bool full,
+                   std::chrono::microseconds stall, std::chrono::microseconds window);
+    // same for a cgroup, path relative to cgroupRoot()
+    int addCgroupTrigger(const std::string& cgroup, enum pressure_resource resource, bool full,
+                         std::chrono::microseconds stall, std::chrono::microseconds window);
+    void removeTrigger(int id);
+
+    // ids of the triggers which fired within timeout, a negative timeout
+    // waits forever. The trigger of a removed cgroup fires once and is
+    // removed.
+    std::vector<int> wait(std::chrono::milliseconds timeout);
+
+private:
+    int add(const std::string& path, bool full, std::chrono::microseconds stall, std::chrono::microseconds window);
+
+    struct trigger_t
+    {
+        int id;
+        int fd;
+    };
+
+    std::vector<struct trigger_t> m_triggers;
+    int m_next_id;
+};
+
+#endif // PRESSURE_H
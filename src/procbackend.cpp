@@ -0,0 +1,382 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "procbackend.h"
+#include "procfs.h"
+#include "instrumentation.h"
+#include "batchreader.h"
+
+#define ARCHIVE_MAGIC "SIPROC01"
+
+namespace {
+
+struct archive_entry_header_t
+{
+    uint8_t kind;
+    uint8_t found;
+    uint16_t reserved;
+    uint32_t path_size;
+    uint64_t content_size;
+};
+
+std::shared_ptr<ProcBackend>& backendStorage()
+{
+    static std::shared_ptr<ProcBackend> backend = std::make_shared<LiveBackend>();
+    return backend;
+}
+
+std::string joinNames(const std::vector<std::string>& names)
+{
+    std::string joined;
+    for (const std::string& name : names)
+    {
+        joined += name;
+        joined.push_back('\0');
+    }
+    return joined;
+}
+
+} // namespace
+
+ProcBackend::~ProcBackend()
+{
+}
+
+ssize_t ProcBackend::readFile(const std::string& path, char* buf, size_t size)
+{
+    std::string content;
+    if (!readFile(path, content))
+        return -1;
+    size_t len = std::min(size, content.size());
+    memcpy(buf, content.data(), len);
+    return len;
+}
+
+bool ProcBackend::isLive() const
+{
+    return false;
+}
+
+bool LiveBackend::readFile(const std::string& path, std::string& content)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return false;
+    // procfs reports a size of 0, read until the end
+    content.resize(4096);
+    size_t total = 0;
+    while (true)
+    {
+        if (total == content.size())
+            content.resize(content.size() * 2);
+        ssize_t nread = read(fd, &content[total], content.size() - total);
+        if (nread < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            // ESRCH once the process exited, partial content is not kept
+            int error = errno;
+            close(fd);
+            content.clear();
+            errno = error;
+            return false;
+        }
+        if (nread == 0)
+            break;
+        total += nread;
+    }
+    close(fd);
+    content.resize(total);
+    return true;
+}
+
+ssize_t LiveBackend::readFile(const std::string& path, char* buf, size_t size)
+{
+    return readFileAt(AT_FDCWD, path.c_str(), buf, size);
+}
+
+bool LiveBackend::readLink(const std::string& path, std::string& target)
+{
+    char buf[4096];
+    ssize_t len = readlink(path.c_str(), buf, sizeof(buf));
+    if (len < 0)
+        return false;
+    target.assign(buf, len);
+    return true;
+}
+
+bool LiveBackend::listDir(const std::string& path, std::vector<std::string>& names)
+{
+    names.clear();
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr)
+        return false;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr)
+    {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+            continue;
+        names.push_back(entry->d_name);
+    }
+    closedir(dir);
+    return true;
+}
+
+bool LiveBackend::isLive() const
+{
+    return true;
+}
+
+bool RecordingBackend::readFile(const std::string& path, std::string& content)
+{
+    bool found = m_live.readFile(path, content);
+    record(path, ENTRY_FILE, found, found ? content : std::string());
+    return found;
+}
+
+ssize_t RecordingBackend::readFile(const std::string& path, char* buf, size_t size)
+{
+    // the whole file is recorded, even if buf is too small
+    std::string content;
+    if (!readFile(path, content))
+        return -1;
+    size_t len = std::min(size, content.size());
+    memcpy(buf, content.data(), len);
+    return len;
+}
+
+bool RecordingBackend::readLink(const std::string& path, std::string& target)
+{
+    bool found = m_live.readLink(path, target);
+    record(path, ENTRY_LINK, found, found ? target : std::string());
+    return found;
+}
+
+bool RecordingBackend::listDir(const std::string& path, std::vector<std::string>& names)
+{
+    bool found = m_live.listDir(path, names);
+    record(path, ENTRY_DIR, found, joinNames(names));
+    return found;
+}
+
+void RecordingBackend::record(const std::string& path, enum entry_kind kind, bool found, const std::string& content)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    struct entry_t& entry = m_entries[path];
+    entry.kind = kind;
+    entry.found = found;
+    entry.content = content;
+}
+
+void RecordingBackend::save(const std::string& archive_path) const
+{
+    std::ofstream archive(archive_path, std::ios::binary | std::ios::trunc);
+    if (!archive.is_open())
+        throw std::string(strerror(errno));
+    archive.write(ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC) - 1);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const std::pair<const std::string, struct entry_t>& it : m_entries)
+    {
+        struct archive_entry_header_t header = archive_entry_header_t();
+        header.kind = it.second.kind;
+        header.found = it.second.found;
+        header.path_size = it.first.size();
+        header.content_size = it.second.content.size();
+        archive.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        archive.write(it.first.data(), it.first.size());
+        archive.write(it.second.content.data(), it.second.content.size());
+    }
+    if (!archive)
+        throw std::string("cannot write " + archive_path);
+}
+
+size_t RecordingBackend::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+void RecordingBackend::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+}
+
+ReplayBackend::ReplayBackend(const std::string& archive_path)
+{
+    std::ifstream archive(archive_path, std::ios::binary);
+    if (!archive.is_open())
+        throw std::string(strerror(errno));
+    char magic[sizeof(ARCHIVE_MAGIC) - 1];
+    if (!archive.read(magic, sizeof(magic)) || memcmp(magic, ARCHIVE_MAGIC, sizeof(magic)) != 0)
+        throw std::string("not a procfs recording: " + archive_path);
+
+    struct archive_entry_header_t header;
+    while (archive.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    {
+        std::string path(header.path_size, '\0');
+        struct RecordingBackend::entry_t entry;
+        entry.kind = static_cast<enum RecordingBackend::entry_kind>(header.kind);
+        entry.found = header.found;
+        entry.content.resize(header.content_size);
+        if (!archive.read(&path[0], path.size()) || !archive.read(&entry.content[0], entry.content.size()))
+            throw std::string("truncated procfs recording: " + archive_path);
+        m_entries[path] = std::move(entry);
+    }
+}
+
+const struct RecordingBackend::entry_t* ReplayBackend::find(const std::string& path,
+                                                            enum RecordingBackend::entry_kind kind) const
+{
+    std::unordered_map<std::string, struct RecordingBackend::entry_t>::const_iterator it = m_entries.find(path);
+    if (it == m_entries.end() || it->second.kind != kind || !it->second.found)
+        return nullptr;
+    return &it->second;
+}
+
+bool ReplayBackend::readFile(const std::string& path, std::string& content)
+{
+    const struct RecordingBackend::entry_t* entry = find(path, RecordingBackend::ENTRY_FILE);
+    if (entry == nullptr)
+        return false;
+    content = entry->content;
+    return true;
+}
+
+bool ReplayBackend::readLink(const std::string& path, std::string& target)
+{
+    const struct RecordingBackend::entry_t* entry = find(path, RecordingBackend::ENTRY_LINK);
+    if (entry == nullptr)
+        return false;
+    target = entry->content;
+    return true;
+}
+
+bool ReplayBackend::listDir(const std::string& path, std::vector<std::string>& names)
+{
+    names.clear();
+    const struct RecordingBackend::entry_t* entry = find(path, RecordingBackend::ENTRY_DIR);
+    if (entry == nullptr)
+        return false;
+    const std::string& content = entry->content;
+    for (size_t begin = 0; begin < content.size();)
+    {
+        size_t end = content.find('\0', begin);
+        names.push_back(content.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return true;
+}
+
+size_t ReplayBackend::size() const
+{
+    return m_entries.size();
+}
+
+void setProcBackend(const std::shared_ptr<ProcBackend>& backend)
+{
+    backendStorage() = backend ? backend : std::make_shared<LiveBackend>();
+}
+
+ProcBackend& procBackend()
+{
+    return *backendStorage();
+}
+
+int probeError(const std::string& path, int error)
+{
+    if (!procBackend().isLive())
+        return 0;
+    if (error != ENOENT && error != ESRCH)
+        return error;
+    // both also come from running processes: ENOENT for the exe of a
+    // kernel thread, ESRCH for its environ. Only a missing <root>/<pid>
+    // means that the process exited.
+    const std::string& root = procRoot();
+    if (path.size() <= root.size() + 1 || path.compare(0, root.size(), root) != 0 || path[root.size()] != '/')
+        return error;
+    size_t begin = root.size() + 1;
+    size_t end = begin;
+    while (end < path.size() && path[end] >= '0' && path[end] <= '9')
+        end++;
+    if (end == begin || (end < path.size() && path[end] != '/'))
+        return error;
+    struct stat st;
+    if (stat(path.substr(0, end).c_str(), &st) != 0 && errno == ENOENT)
+        return ESRCH;
+    return ENOENT;
+}
+
+ssize_t readProcFile(const std::string& path, char* buf, size_t size)
+{
+    const struct batch_read_t* batched = BatchScope::find(path);
+    if (batched != nullptr)
+    {
+        SourceProbe::read(batched->result, 0, batched->result < 0 ? probeError(path, -batched->result) : 0);
+        if (batched->result < 0)
+            return -1;
+        size_t len = std::min(size, batched->content.size());
+        memcpy(buf, batched->content.data(), len);
+        return len;
+    }
+    if (!SourceProbe::active())
+        return procBackend().readFile(path, buf, size);
+    unsigned long long start = SourceProbe::now();
+    ssize_t len = procBackend().readFile(path, buf, size);
+    int error = len < 0 ? probeError(path, errno) : 0;
+    SourceProbe::read(len, SourceProbe::now() - start, error);
+    return len;
+}
+
+bool readProcLink(const std::string& path, std::string& target)
+{
+    if (!SourceProbe::active())
+        return procBackend().readLink(path, target);
+    unsigned long long start = SourceProbe::now();
+    bool found = procBackend().readLink(path, target);
+    int error = found ? 0 : probeError(path, errno);
+    SourceProbe::read(found ? target.size() : -1, SourceProbe::now() - start, error);
+    return found;
+}
+
+ProcStream::ProcStream(const std::string& path)
+{
+    std::string content;
+    const struct batch_read_t* batched = BatchScope::find(path);
+    if (batched != nullptr)
+    {
+        SourceProbe::read(batched->result, 0, batched->result < 0 ? probeError(path, -batched->result) : 0);
+        m_open = batched->result >= 0;
+        content = batched->content;
+    }
+    else if (SourceProbe::active())
+    {
+        unsigned long long start = SourceProbe::now();
+        m_open = procBackend().readFile(path, content);
+        int error = m_open ? 0 : probeError(path, errno);
+        SourceProbe::read(m_open ? content.size() : -1, SourceProbe::now() - start, error);
+    }
+    else
+    {
+        m_open = procBackend().readFile(path, content);
+    }
+    str(content);
+}
+
+bool ProcStream::is_open() const
+{
+    return m_open;
+}
+
+void ProcStream::close()
+{
+}
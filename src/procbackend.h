@@ -0,0 +1,134 @@
+#ifndef PROCBACKEND_H
+#define PROCBACKEND_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/types.h>
+
+// Source of the procfs content read by the library
+//
+// Every reader goes through the current backend, so a scan can be served
+// by the live system, recorded while reading it, or replayed from memory.
+class ProcBackend
+{
+public:
+    virtual ~ProcBackend();
+
+    // false if the file cannot be read (process gone, permission, ...)
+    virtual bool readFile(const std::string& path, std::string& content) = 0;
+    // into buf, -1 if the file cannot be read
+    virtual ssize_t readFile(const std::string& path, char* buf, size_t size);
+    virtual bool readLink(const std::string& path, std::string& target) = 0;
+    // entry names, without . and ..
+    virtual bool listDir(const std::string& path, std::vector<std::string>& names) = 0;
+
+    // true if the readers can bypass the backend and use their own
+    // syscalls (directory fds, getdents64, readlinkat)
+    virtual bool isLive() const;
+};
+
+// the running system
+class LiveBackend : public ProcBackend
+{
+public:
+    bool readFile(const std::string& path, std::string& content) override;
+    ssize_t readFile(const std::string& path, char* buf, size_t size) override;
+    bool readLink(const std::string& path, std::string& target) override;
+    bool listDir(const std::string& path, std::vector<std::string>& names) override;
+    bool isLive() const override;
+};
+
+// Reads the live system and keeps a copy of everything read, failures
+// included, until save() writes it into a single archive
+class RecordingBackend : public ProcBackend
+{
+public:
+    bool readFile(const std::string& path, std::string& content) override;
+    ssize_t readFile(const std::string& path, char* buf, size_t size) override;
+    bool readLink(const std::string& path, std::string& target) override;
+    bool listDir(const std::string& path, std::vector<std::string>& names) override;
+
+    void save(const std::string& archive_path) const;
+    // number of recorded paths
+    size_t size() const;
+    void clear();
+
+    enum entry_kind
+    {
+        ENTRY_FILE = 1,
+        ENTRY_LINK = 2,
+        ENTRY_DIR = 3
+    };
+
+    struct entry_t
+    {
+        enum entry_kind kind;
+        // false if the read failed
+        bool found;
+        // file content, link target or '\0' separated entry names
+        std::string content;
+    };
+
+private:
+    void record(const std::string& path, enum entry_kind kind, bool found, const std::string& content);
+
+    LiveBackend m_live;
+    mutable std::mutex m_mutex;
+    // the last read of each path wins
+    std::map<std::string, struct entry_t> m_entries;
+};
+
+// Serves the content of a RecordingBackend archive from memory, the paths
+// which were not recorded behave like vanished processes
+class ReplayBackend : public ProcBackend
+{
+public:
+    ReplayBackend(const std::string& archive_path);
+
+    bool readFile(const std::string& path, std::string& content) override;
+    bool readLink(const std::string& path, std::string& target) override;
+    bool listDir(const std::string& path, std::vector<std::string>& names) override;
+
+    size_t size() const;
+
+private:
+    const struct RecordingBackend::entry_t* find(const std::string& path,
+                                                 enum RecordingBackend::entry_kind kind) const;
+
+    std::unordered_map<std::string, struct RecordingBackend::entry_t> m_entries;
+};
+
+// backend used by every reader, live by default
+// must be set before any reader is used, like the proc root
+void setProcBackend(const std::shared_ptr<ProcBackend>& backend);
+ProcBackend& procBackend();
+
+// through procBackend(), the reads are reported to the active SourceProbe
+// the files prefetched by an active BatchScope are served from memory
+ssize_t readProcFile(const std::string& path, char* buf, size_t size);
+bool readProcLink(const std::string& path, std::string& target);
+// errno of a failed read of path for SourceProbe::read(): ESRCH only when
+// the pid directory of path is gone, 0 with a replayed backend
+int probeError(const std::string& path, int error);
+
+// a whole procfs file read through procBackend(), for the line based readers
+class ProcStream : public std::istringstream
+{
+public:
+    explicit ProcStream(const std::string& path);
+
+    // false if the file could not be read
+    bool is_open() const;
+    void close();
+
+private:
+    bool m_open;
+};
+
+#endif // PROCBACKEND_H
@@ -1,12 +1,13 @@
 #include <cstring>
 #include <cerrno>
 #include <unistd.h>
+#include <sys/time.h>
 #include <string>
 
 #include "procconnector.h"
 
 ProcConnector::ProcConnector()
-    : m_thread_listen(nullptr)
+    : m_thread_listen(nullptr), m_stop(false)
 {
     connect();
     subscribe();
@@ -14,9 +15,14 @@ ProcConnector::ProcConnector()
 
 ProcConnector::~ProcConnector()
 {
-    close(m_nl_sock);
+    // the listening thread sees the flag at its next receive timeout
+    m_stop = true;
     if (m_thread_listen != nullptr)
+    {
+        m_thread_listen->join();
         delete m_thread_listen;
+    }
+    close(m_nl_sock);
 }
 
 void ProcConnector::connect()
@@ -41,31 +47,37 @@ void ProcConnector::connect()
         close(m_nl_sock);
         throw std::string(strerror(errno));
     }
+
+    // wake up regularly to check m_stop
+    struct timeval timeout;
+    timeout.tv_sec = 0;
+    timeout.tv_usec = 100000;
+    setsockopt(m_nl_sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
 }
 
 void ProcConnector::subscribe()
 {
     int rc;
-    struct __attribute__ ((aligned(NLMSG_ALIGNTO))) {
-        struct nlmsghdr nl_hdr;
-        struct __attribute__ ((__packed__)) {
-            struct cn_msg cn_msg;
-            enum proc_cn_mcast_op cn_mcast;
-        };
-    } nlcn_msg;
-
-    memset(&nlcn_msg, 0, sizeof(nlcn_msg));
-    nlcn_msg.nl_hdr.nlmsg_len = sizeof(nlcn_msg);
-    nlcn_msg.nl_hdr.nlmsg_pid = getpid();
-    nlcn_msg.nl_hdr.nlmsg_type = NLMSG_DONE;
-
-    nlcn_msg.cn_msg.id.idx = CN_IDX_PROC;
-    nlcn_msg.cn_msg.id.val = CN_VAL_PROC;
-    nlcn_msg.cn_msg.len = sizeof(enum proc_cn_mcast_op);
-
-    nlcn_msg.cn_mcast = PROC_CN_MCAST_LISTEN; // PROC_CN_MCAST_IGNORE;
-
-    rc = send(m_nl_sock, &nlcn_msg, sizeof(nlcn_msg), 0);
+    // cn_msg ends with a flexible array member, so the message cannot be
+    // declared as a nested struct: lay it out by hand in an aligned buffer
+    char __attribute__ ((aligned(NLMSG_ALIGNTO))) buf[NLMSG_SPACE(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op))];
+
+    memset(buf, 0, sizeof(buf));
+    struct nlmsghdr* nl_hdr = reinterpret_cast<struct nlmsghdr*>(buf);
+    struct cn_msg* cn_msg = reinterpret_cast<struct cn_msg*>(NLMSG_DATA(nl_hdr));
+    enum proc_cn_mcast_op* cn_mcast = reinterpret_cast<enum proc_cn_mcast_op*>(cn_msg->data);
+
+    nl_hdr->nlmsg_len = NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op));
+    nl_hdr->nlmsg_pid = getpid();
+    nl_hdr->nlmsg_type = NLMSG_DONE;
+
+    cn_msg->id.idx = CN_IDX_PROC;
+    cn_msg->id.val = CN_VAL_PROC;
+    cn_msg->len = sizeof(enum proc_cn_mcast_op);
+
+    *cn_mcast = PROC_CN_MCAST_LISTEN; // PROC_CN_MCAST_IGNORE;
+
+    rc = send(m_nl_sock, buf, nl_hdr->nlmsg_len, 0);
     if (rc == -1) {
         throw std::string(strerror(errno));
     }
@@ -90,24 +102,18 @@ void ProcConnector::listen(bool block)
 
 void ProcConnector::listenBlock()
 {
-    while (1)
+    while (!m_stop)
         processEvent();
 }
 
 void ProcConnector::processEvent()
 {
     int rc;
-    struct __attribute__ ((aligned(NLMSG_ALIGNTO))) {
-        struct nlmsghdr nl_hdr;
-        struct __attribute__ ((__packed__)) {
-            struct cn_msg cn_msg;
-            struct proc_event proc_ev;
-        };
-    } nlcn_msg;
-
-    rc = recv(m_nl_sock, &nlcn_msg, sizeof(nlcn_msg), 0);
+    char __attribute__ ((aligned(NLMSG_ALIGNTO))) buf[NLMSG_SPACE(sizeof(struct cn_msg) + sizeof(struct proc_event))];
+
+    rc = recv(m_nl_sock, buf, sizeof(buf), 0);
     if (rc == -1) {
-        if (errno == EINTR)
+        if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)
             return;
         else
         {
@@ -115,6 +121,9 @@ void ProcConnector::processEvent()
             return;
         }
     }
+    struct nlmsghdr* nl_hdr = reinterpret_cast<struct nlmsghdr*>(buf);
+    struct cn_msg* cn_msg = reinterpret_cast<struct cn_msg*>(NLMSG_DATA(nl_hdr));
+    struct proc_event* proc_ev = reinterpret_cast<struct proc_event*>(cn_msg->data);
     for (std::function<void(struct proc_event)> callback: m_subscribers)
-        callback(nlcn_msg.proc_ev);
+        callback(*proc_ev);
 }
@@ -1,6 +1,7 @@
 #ifndef PROCCONNECTOR_H
 #define PROCCONNECTOR_H
 
+#include <atomic>
 #include <functional>
 #include <vector>
 #include <thread>
@@ -26,6 +27,7 @@ private:
 
     int m_nl_sock;
     std::thread* m_thread_listen;
+    std::atomic<bool> m_stop;
     std::vector<std::function<void(struct proc_event)>> m_subscribers;
 };
 
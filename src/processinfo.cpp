@@ -1,8 +1,8 @@
 #include <fstream>
 #include <algorithm>
 #include <functional>
+#include <atomic>
 #include <boost/regex.hpp>
-#include <boost/filesystem.hpp>
 #include <boost/algorithm/string.hpp>
 
 #include <fcntl.h>
@@ -10,9 +10,19 @@
 #include <sys/sysinfo.h>
 
 #include "processinfo.h"
+#include "sysinfo.h"
+#include "ttyindex.h"
+#include "usercache.h"
+#include "procfs.h"
+#include "procbackend.h"
+#include "instrumentation.h"
+#include "procstat.h"
 
 // static init
-std::unordered_map<int, ProcessInfo*> ProcessInfo::map_pid_oldstate;
+std::unordered_map<int, struct ProcessInfo::oldstate_t> ProcessInfo::map_pid_oldstate;
+std::atomic<unsigned long> ProcessInfo::s_read_count[FIELD_GROUP_COUNT];
+std::chrono::milliseconds ProcessInfo::s_default_max_age[FIELD_GROUP_COUNT];
+std::mutex ProcessInfo::s_default_max_age_mutex;
 
 // overload operator<<
 std::ostream& operator<<(std::ostream& os, ProcessInfo& p)
@@ -22,43 +32,57 @@ std::ostream& operator<<(std::ostream& os, ProcessInfo& p)
     os << "Parent PID : " << p.ppid() << std::endl;
     os << "Process Group ID : " << p.pgid() << std::endl;
     os << "Session ID : " << p.sid() << std::endl;
-    os << "Controlling tty : " << "Major : " << MAJOR(p.m_tty_nr) << ", Minor : " << MINOR(p.m_tty_nr) << " (" << p.ttyNr() << ")" << std::endl;
-    os << "starttime : " << "jiffies : " << p.m_starttime << ", diff : " << p.startTime() << std::endl;
-    os << "Threads : " << p.m_num_threads << std::endl;
+    os << "Controlling tty : " << "Major : " << MAJOR(p.m_hot.tty_nr) << ", Minor : " << MINOR(p.m_hot.tty_nr) << " (" << p.ttyNr() << ")" << std::endl;
+    os << "starttime : " << "jiffies : " << p.m_hot.starttime << ", diff : " << p.startTime() << std::endl;
+    os << "Threads : " << p.m_hot.num_threads << std::endl;
     os << "Opened Files :" << std::endl;
-    const std::unordered_map<int, std::string>& fds = p.fds();
-    std::unordered_map<int, std::string>::const_iterator it;
+    const std::unordered_map<int, boost::string_view> fds = p.fds();
+    std::unordered_map<int, boost::string_view>::const_iterator it;
     for (it = fds.begin(); it != fds.end(); it++)
         os << "[" << it->first << "]" << " => " << it->second << std::endl;
-    std::cout << "user name : " << p.userName() << std::endl;
+    os << "user name : " << p.userName() << std::endl;
     return os;
 }
 
 ProcessInfo::ProcessInfo()
+    : m_hot(hot_t()), m_io(io_stat()), m_arena(std::make_shared<StringArena>())
 {
-    m_pid = 0;
+    m_need_update = 0;
+    m_max_age_fields = 0;
+    m_voluntary_ctxt_switches = 0;
+    m_nonvoluntary_ctxt_switches = 0;
 }
 
-ProcessInfo::ProcessInfo(pid_t pid)
+ProcessInfo::ProcessInfo(pid_t pid, unsigned int fields, const std::shared_ptr<StringArena>& arena)
+    : m_hot(hot_t()), m_io(io_stat()), m_arena(arena)
 {
-    m_pid = pid;
-    m_proc_path = "/proc/" + std::to_string(pid) + "/";
-    m_need_update_stat = false;
-    m_need_update_status = false;
-    m_need_update_io = false;
-    m_need_update_cwd = false;
-    m_need_update_exe = false;
-    m_need_update_cmdline = false;
-    m_need_update_root = false;
-    m_need_update_environ = false;
-    m_need_update_fd = false;
-    m_need_update_wchan = false;
-    m_need_update_smaps = false;
-    m_need_update_cpu_usage = false;
-    m_need_update_io_read_usage = false;
-    m_need_update_io_write_usage = false;
+    if (!m_arena)
+        m_arena = std::make_shared<StringArena>();
+    m_hot.pid = pid;
+    m_proc_path = procPath(std::to_string(pid)) + "/";
+    m_voluntary_ctxt_switches = 0;
+    m_nonvoluntary_ctxt_switches = 0;
+    m_cwd = StringArena::empty;
+    m_exe = StringArena::empty;
+    m_root = StringArena::empty;
+
+    // process wide refresh policy
+    m_max_age_fields = 0;
+    {
+        std::lock_guard<std::mutex> lock(s_default_max_age_mutex);
+        for (int i = 0; i < FIELD_GROUP_COUNT; i++)
+        {
+            if (s_default_max_age[i].count() > 0)
+            {
+                aging().max_age[i] = s_default_max_age[i];
+                m_max_age_fields |= 1u << i;
+            }
+        }
+    }
 
     this->needUpdate();
+    // read the requested groups right away, the others stay lazy
+    update(fields);
 }
 
 ProcessInfo::~ProcessInfo()
@@ -68,261 +92,304 @@ ProcessInfo::~ProcessInfo()
 
 void ProcessInfo::needUpdate()
 {
-    m_need_update_stat = true;
-    m_need_update_status = true;
-    m_need_update_io = true;
-    m_need_update_cwd = true;
-    m_need_update_exe = true;
-    m_need_update_cmdline = true;
-    m_need_update_root = true;
-    m_need_update_environ = true;
-    m_need_update_fd = true;
-    m_need_update_wchan = true;
-    m_need_update_smaps = true;
-    m_need_update_cpu_usage = true;
-    m_need_update_io_read_usage = true;
-    m_need_update_io_write_usage = true;
+    m_need_update = FIELD_ALL
+            | NEED_UPDATE_CPU_USAGE
+            | NEED_UPDATE_IO_READ_USAGE
+            | NEED_UPDATE_IO_WRITE_USAGE;
+}
+
+void ProcessInfo::update(unsigned int fields)
+{
+    // expire the groups older than their max age
+    unsigned int expiring = fields & m_max_age_fields & ~m_need_update;
+    std::chrono::steady_clock::time_point now;
+    if (expiring != 0 || (m_need_update & fields & m_max_age_fields) != 0)
+        now = std::chrono::steady_clock::now();
+    for (int i = 0; expiring != 0; i++, expiring >>= 1)
+    {
+        if ((expiring & 1) && now - m_aging->read_time[i] >= m_aging->max_age[i])
+            m_need_update |= 1u << i;
+    }
+
+    unsigned int dirty = m_need_update & fields & FIELD_ALL;
+    for (int i = 0; dirty != 0; i++, dirty >>= 1)
+    {
+        if (!(dirty & 1))
+            continue;
+        SourceProbe probe(static_cast<enum data_source>(i));
+        switch (1 << i)
+        {
+        case FIELD_STAT:
+            readStat();
+            break;
+        case FIELD_STATUS:
+            readStatus();
+            break;
+        case FIELD_IO:
+            readIo();
+            break;
+        case FIELD_CMDLINE:
+            readCmdline();
+            break;
+        case FIELD_CWD:
+            readCwd();
+            break;
+        case FIELD_EXE:
+            readExe();
+            break;
+        case FIELD_ROOT:
+            readRoot();
+            break;
+        case FIELD_ENVIRON:
+            readEnviron();
+            break;
+        case FIELD_FD:
+            readFd();
+            break;
+        case FIELD_WCHAN:
+            readWchan();
+            break;
+        case FIELD_SMAPS:
+            readSmaps();
+            break;
+        case FIELD_CGROUP:
+            readCgroup();
+            break;
+        case FIELD_LIMITS:
+            readLimits();
+            break;
+        case FIELD_STACK:
+            readStack();
+            break;
+        }
+        s_read_count[i]++;
+        m_need_update &= ~(1u << i);
+        if (m_max_age_fields & (1u << i))
+            m_aging->read_time[i] = now;
+        // the computed values depend on the new content
+        if ((1 << i) == FIELD_STAT)
+            m_need_update |= NEED_UPDATE_CPU_USAGE;
+        else if ((1 << i) == FIELD_IO)
+            m_need_update |= NEED_UPDATE_IO_READ_USAGE | NEED_UPDATE_IO_WRITE_USAGE;
+    }
+}
+
+void ProcessInfo::setMaxAge(unsigned int fields, std::chrono::milliseconds max_age)
+{
+    for (int i = 0; i < FIELD_GROUP_COUNT; i++)
+    {
+        if (!(fields & (1u << i)))
+            continue;
+        if (max_age.count() > 0)
+        {
+            aging().max_age[i] = max_age;
+            // age unknown, read again on next access
+            if (!(m_max_age_fields & (1u << i)))
+                m_need_update |= 1u << i;
+            m_max_age_fields |= 1u << i;
+        }
+        else
+        {
+            if (m_aging)
+                m_aging->max_age[i] = max_age;
+            m_max_age_fields &= ~(1u << i);
+        }
+    }
+}
+
+std::chrono::milliseconds ProcessInfo::maxAge(enum field_group group) const
+{
+    for (int i = 0; i < FIELD_GROUP_COUNT; i++)
+        if (group == (1 << i) && (m_max_age_fields & (1u << i)))
+            return m_aging->max_age[i];
+    return std::chrono::milliseconds(0);
+}
+
+void ProcessInfo::setDefaultMaxAge(unsigned int fields, std::chrono::milliseconds max_age)
+{
+    std::lock_guard<std::mutex> lock(s_default_max_age_mutex);
+    for (int i = 0; i < FIELD_GROUP_COUNT; i++)
+        if (fields & (1u << i))
+            s_default_max_age[i] = max_age;
+}
+
+struct ProcessInfo::cold_t& ProcessInfo::cold()
+{
+    if (!m_cold)
+        m_cold.reset(new cold_t());
+    return *m_cold;
+}
+
+struct ProcessInfo::aging_t& ProcessInfo::aging()
+{
+    if (!m_aging)
+        m_aging.reset(new aging_t());
+    return *m_aging;
+}
+
+unsigned long ProcessInfo::readCount(enum field_group group)
+{
+    for (int i = 0; i < FIELD_GROUP_COUNT; i++)
+        if (group == (1 << i))
+            return s_read_count[i];
+    return 0;
+}
+
+void ProcessInfo::resetReadCounts()
+{
+    for (int i = 0; i < FIELD_GROUP_COUNT; i++)
+        s_read_count[i] = 0;
 }
 
 // getters
 // from stat
-pid_t ProcessInfo::pid() const { return m_pid; }
+pid_t ProcessInfo::pid() const { return m_hot.pid; }
 
 const std::string ProcessInfo::name()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
+    update(FIELD_STAT);
     return  m_name;
 }
 
 const std::string& ProcessInfo::state()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
-    return m_state;
+    update(FIELD_STAT);
+    // one shared string per state letter
+    static const std::vector<std::string> names = []() {
+        std::vector<std::string> names(128);
+        for (int c = 0; c < 128; c++)
+            names[c] = std::string(1, static_cast<char>(c));
+        names['R'] = "Running";
+        names['S'] = "Sleeping";
+        names['D'] = "Disk sleep";
+        names['Z'] = "Zombie";
+        names['T'] = "Stopped";
+        names['W'] = "Waking";
+        return names;
+    }();
+    return names[m_hot.state & 0x7f];
 }
 
 int ProcessInfo::ppid()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
-    return m_ppid;
+    update(FIELD_STAT);
+    return m_hot.ppid;
 }
 
 int ProcessInfo::pgid()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
-    return m_pgid;
+    update(FIELD_STAT);
+    return m_hot.pgid;
 }
 
 int ProcessInfo::sid()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
-    return m_session;
+    update(FIELD_STAT);
+    return m_hot.session;
 }
 
 const std::string ProcessInfo::ttyNr()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
+    update(FIELD_STAT);
+    return TtyIndex::instance().name(static_cast<dev_t>(m_hot.tty_nr));
+}
 
-    // /dev/tty* ?
-    boost::filesystem::path path("/dev");
-    boost::filesystem::directory_iterator end_itr;
-    for (boost::filesystem::directory_iterator itr(path);
-         itr != end_itr;
-         ++itr)
-    {
-        if (boost::regex_match(itr->path().filename().string(), boost::regex("^tty\\d*$")))
-        {
-            // stat
-            struct stat st;
-            if (stat(itr->path().string().c_str(), &st) == 0)
-            {
-                // corresponding st_dev ?
-                if (m_tty_nr == st.st_rdev)
-                    return itr->path().string();
-            }
-        }
-    }
-    // /dev/pts ?
-    path = "/dev/pts";
-    for (boost::filesystem::directory_iterator itr(path);
-         itr != end_itr;
-         ++itr)
-    {
-        // stat
-        struct stat st;
-        if (stat(itr->path().string().c_str(), &st) == 0)
-        {
-            // corresponding st_rdev ?
-            if (m_tty_nr == st.st_rdev)
-                return itr->path().string();
-        }
-    }
-    return std::string();
+int ProcessInfo::ttyDevice()
+{
+    update(FIELD_STAT);
+    return m_hot.tty_nr;
 }
 
 int ProcessInfo::tpgid()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
-    return m_tpgid;
+    update(FIELD_STAT);
+    return m_hot.tpgid;
 }
 
 unsigned int ProcessInfo::flags()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
-    return m_flags;
+    update(FIELD_STAT);
+    return m_hot.flags;
 }
 
 long unsigned int ProcessInfo::minflt()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
-    return m_minflt;
+    update(FIELD_STAT);
+    return m_hot.minflt;
 }
 
 long unsigned int ProcessInfo::cminflt()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
-    return m_cminflt;
+    update(FIELD_STAT);
+    return m_hot.cminflt;
 }
 
 long unsigned int ProcessInfo::majflt()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
-    return m_majflt;
+    update(FIELD_STAT);
+    return m_hot.majflt;
 }
 
 long unsigned int ProcessInfo::cmajflt()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
-    return m_cmajflt;
+    update(FIELD_STAT);
+    return m_hot.cmajflt;
 }
 
 long unsigned int ProcessInfo::utime()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
-    return m_utime;
+    update(FIELD_STAT);
+    return m_hot.utime;
 }
 
 long unsigned int ProcessInfo::stime()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
-    return m_stime;
+    update(FIELD_STAT);
+    return m_hot.stime;
 }
 
 long unsigned int ProcessInfo::cutime()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
-    return m_cutime;
+    update(FIELD_STAT);
+    return m_hot.cutime;
 }
 
 long unsigned int ProcessInfo::cstime()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
-    return m_cstime;
+    update(FIELD_STAT);
+    return m_hot.cstime;
 }
 
 long int ProcessInfo::priority()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
-    return m_priority;
+    update(FIELD_STAT);
+    return m_hot.priority;
 }
 
 long int ProcessInfo::nice()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
-    return m_nice;
+    update(FIELD_STAT);
+    return m_hot.nice;
 }
 
 long int ProcessInfo::numThreads()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
-    return m_num_threads;
+    update(FIELD_STAT);
+    return m_hot.num_threads;
+}
+
+long long unsigned int ProcessInfo::startTicks()
+{
+    update(FIELD_STAT);
+    return m_hot.starttime;
 }
 
 long long unsigned int ProcessInfo::startTime()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
+    update(FIELD_STAT);
     // convert jiffies to seconds
     long hz = sysconf(_SC_CLK_TCK);
-    long long unsigned int starttime_sec = m_starttime / hz;
+    long long unsigned int starttime_sec = m_hot.starttime / hz;
     // get uptime
     struct sysinfo info;
     sysinfo(&info);
@@ -333,103 +400,69 @@ long long unsigned int ProcessInfo::startTime()
 
 long unsigned int ProcessInfo::vmSize()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
-    return m_vmsize;
+    update(FIELD_STAT);
+    return m_hot.vmsize;
+}
+
+long int ProcessInfo::rss()
+{
+    update(FIELD_STAT);
+    return m_hot.rss;
 }
 
 long unsigned int ProcessInfo::startCode()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
+    update(FIELD_STAT);
     return m_startcode;
 }
 
 long unsigned int ProcessInfo::endCode()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
+    update(FIELD_STAT);
     return m_endcode;
 }
 
 long unsigned int ProcessInfo::startStack()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
+    update(FIELD_STAT);
     return m_startstack;
 }
 
 long unsigned int ProcessInfo::kstkEsp()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
+    update(FIELD_STAT);
     return m_kstkesp;
 }
 
 long unsigned int ProcessInfo::kstkEip()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
+    update(FIELD_STAT);
     return m_kstkeip;
 }
 
 long unsigned int ProcessInfo::wchanAddr()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
+    update(FIELD_STAT);
     return m_wchan_addr;
 }
 
 int ProcessInfo::processor()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
-    return m_processor;
+    update(FIELD_STAT);
+    return m_hot.processor;
 }
 
 unsigned int ProcessInfo::rtPriority()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
-    return m_rt_priority;
+    update(FIELD_STAT);
+    return m_hot.rt_priority;
 }
 
 std::string ProcessInfo::policy()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
+    update(FIELD_STAT);
 
-    switch (m_policy)
+    switch (m_hot.policy)
     {
     case SCHED_NORMAL:
         return "SCHED_NORMAL";
@@ -449,398 +482,345 @@ std::string ProcessInfo::policy()
 
 long long unsigned int ProcessInfo::delayacctBlkioTicks()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
+    update(FIELD_STAT);
     return m_delayacct_blkio_ticks;
 }
 
 long unsigned int ProcessInfo::guestTime()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
+    update(FIELD_STAT);
     return m_guest_time;
 }
 
 long unsigned int ProcessInfo::cguestTime()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
+    update(FIELD_STAT);
     return m_cguest_time;
 }
 
 long unsigned int ProcessInfo::startData()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
+    update(FIELD_STAT);
     return m_start_data;
 }
 
 long unsigned int ProcessInfo::endData()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
+    update(FIELD_STAT);
     return m_end_data;
 }
 
 long unsigned int ProcessInfo::startBrk()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
+    update(FIELD_STAT);
     return m_start_brk;
 }
 
 long unsigned int ProcessInfo::startArg()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
+    update(FIELD_STAT);
     return m_arg_start;
 }
 
 long unsigned int ProcessInfo::endArg()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
+    update(FIELD_STAT);
     return m_arg_end;
 }
 
 long unsigned int ProcessInfo::startEnv()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
+    update(FIELD_STAT);
     return m_env_start;
 }
 
 long unsigned int ProcessInfo::endEnv()
 {
-    if (m_need_update_stat)
-    {
-        readStat();
-        m_need_update_stat = false;
-    }
+    update(FIELD_STAT);
     return m_env_end;
 }
 
 // from cmdline
 const std::vector<std::string>& ProcessInfo::cmdline()
 {
-    if (m_need_update_cmdline)
-    {
-        readCmdline();
-        m_need_update_cmdline = false;
-    }
+    update(FIELD_CMDLINE);
     return m_cmdline;
 }
 
 // from cwd
-const std::string ProcessInfo::cwd()
+boost::string_view ProcessInfo::cwd()
 {
-    if (m_need_update_cwd)
-    {
-        readCwd();
-        m_need_update_cwd = false;
-    }
-    return m_cwd;
+    update(FIELD_CWD);
+    return m_arena->view(m_cwd);
 }
 
 // from exe
-const std::string ProcessInfo::exe()
+boost::string_view ProcessInfo::exe()
 {
-    if (m_need_update_exe)
-    {
-        readExe();
-        m_need_update_exe = false;
-    }
-    return m_exe;
+    update(FIELD_EXE);
+    return m_arena->view(m_exe);
 }
 
 // from root
-const std::string ProcessInfo::root()
+boost::string_view ProcessInfo::root()
 {
-    if (m_need_update_root)
-    {
-        readRoot();
-        m_need_update_root = false;
-    }
-    return m_root;
+    update(FIELD_ROOT);
+    return m_arena->view(m_root);
 }
 
 // from environ
 const std::unordered_map<std::string, std::string> ProcessInfo::environ()
 {
-    if (m_need_update_environ)
-    {
-        readEnviron();
-        m_need_update_environ = false;
-    }
-    return m_environ;
+    update(FIELD_ENVIRON);
+    return cold().environ;
 }
 
 // from io
 long unsigned int ProcessInfo::readBytes()
 {
-    if (m_need_update_io)
-    {
-        readIo();
-        m_need_update_io = false;
-    }
+    update(FIELD_IO);
     return m_io.read_bytes;
 }
 
 long unsigned int ProcessInfo::writeBytes()
 {
-    if (m_need_update_io)
-    {
-        readIo();
-        m_need_update_io = false;
-    }
+    update(FIELD_IO);
     return m_io.write_bytes;
 }
 
 // from status
 const std::string ProcessInfo::userName()
 {
-    if (m_need_update_status)
-    {
-        readStatus();
-        m_need_update_status = false;
-    }
-    std::string username;
-    struct passwd* pass = nullptr;
-    pass = getpwuid(m_uids[0]); // real uid
-    if (pass == nullptr)
+    update(FIELD_STATUS);
+    if (m_uids.empty())
+        return std::string();
+    std::string username = UserCache::instance().userName(m_uids[0]); // real uid
+    if (username.empty())
     {
         // the process is in a container, but is still visible
         // returns the uid as the username for now
         username = std::to_string(m_uids[0]);
     }
-    else
-        username = std::string(pass->pw_name);
     return username;
 }
 
+const std::string ProcessInfo::groupName()
+{
+    update(FIELD_STATUS);
+    if (m_gids.empty())
+        return std::string();
+    std::string groupname = UserCache::instance().groupName(m_gids[0]); // real gid
+    if (groupname.empty())
+        groupname = std::to_string(m_gids[0]);
+    return groupname;
+}
+
 const std::vector<int>& ProcessInfo::uids()
 {
-    if (m_need_update_status)
-    {
-        readStatus();
-        m_need_update_status = false;
-    }
+    update(FIELD_STATUS);
     return m_uids;
 }
 
 const std::vector<int>& ProcessInfo::gids()
 {
-    if (m_need_update_status)
-    {
-        readStatus();
-        m_need_update_status = false;
-    }
+    update(FIELD_STATUS);
     return m_gids;
 }
 
 long unsigned int ProcessInfo::vmPeak()
 {
-    if (m_need_update_status)
-    {
-        readStatus();
-        m_need_update_status = false;
-    }
+    update(FIELD_STATUS);
     return m_vm_peak;
 }
 
 long unsigned int ProcessInfo::vmLck()
 {
-    if (m_need_update_status)
-    {
-        readStatus();
-        m_need_update_status = false;
-    }
+    update(FIELD_STATUS);
     return m_vm_lck;
 }
 
 long unsigned int ProcessInfo::vmPin()
 {
-    if (m_need_update_status)
-    {
-        readStatus();
-        m_need_update_status = false;
-    }
+    update(FIELD_STATUS);
     return m_vm_pin;
 }
 
 long unsigned int ProcessInfo::vmHwm()
 {
-    if (m_need_update_status)
-    {
-        readStatus();
-        m_need_update_status = false;
-    }
+    update(FIELD_STATUS);
     return m_vm_hwm;
 }
 
 long unsigned int ProcessInfo::vmRss()
 {
-    if (m_need_update_status)
-    {
-        readStatus();
-        m_need_update_status = false;
-    }
-    return m_vm_rss;
+    update(FIELD_STATUS);
+    return m_hot.vm_rss;
 }
 
 long unsigned int ProcessInfo::vmData()
 {
-    if (m_need_update_status)
-    {
-        readStatus();
-        m_need_update_status = false;
-    }
+    update(FIELD_STATUS);
     return m_vm_data;
 }
 
 long unsigned int ProcessInfo::vmStk()
 {
-    if (m_need_update_status)
-    {
-        readStatus();
-        m_need_update_status = false;
-    }
+    update(FIELD_STATUS);
     return m_vm_stk;
 }
 
 long unsigned int ProcessInfo::vmExe()
 {
-    if (m_need_update_status)
-    {
-        readStatus();
-        m_need_update_status = false;
-    }
+    update(FIELD_STATUS);
     return m_vm_exe;
 }
 
 long unsigned int ProcessInfo::vmLib()
 {
-    if (m_need_update_status)
-    {
-        readStatus();
-        m_need_update_status = false;
-    }
+    update(FIELD_STATUS);
     return m_vm_lib;
 }
 
 long unsigned int ProcessInfo::vmPte()
 {
-    if (m_need_update_status)
-    {
-        readStatus();
-        m_need_update_status = false;
-    }
+    update(FIELD_STATUS);
     return m_vm_pte;
 }
 
 long unsigned int ProcessInfo::vmPmd()
 {
-    if (m_need_update_status)
-    {
-        readStatus();
-        m_need_update_status = false;
-    }
+    update(FIELD_STATUS);
     return m_vm_pmd;
 }
 
 long unsigned int ProcessInfo::vmSwap()
 {
-    if (m_need_update_status)
-    {
-        readStatus();
-        m_need_update_status = false;
-    }
-    return m_vm_swap;
+    update(FIELD_STATUS);
+    return m_hot.vm_swap;
+}
+
+long unsigned int ProcessInfo::voluntaryCtxtSwitches()
+{
+    update(FIELD_STATUS);
+    return m_voluntary_ctxt_switches;
+}
+
+long unsigned int ProcessInfo::nonvoluntaryCtxtSwitches()
+{
+    update(FIELD_STATUS);
+    return m_nonvoluntary_ctxt_switches;
 }
 
 
 // from fd
-const std::unordered_map<int, std::string>& ProcessInfo::fds()
+std::unordered_map<int, boost::string_view> ProcessInfo::fds()
+{
+    update(FIELD_FD);
+    std::unordered_map<int, boost::string_view> fds;
+    for (const std::pair<const int, std::string>& fd : m_fds)
+        fds[fd.first] = fd.second;
+    return fds;
+}
+
+long ProcessInfo::fdCount()
 {
-    if (m_need_update_fd)
+    if (!(m_need_update & FIELD_FD))
+        return m_fds.size();
+    // count only, without resolving any link
+    FdReader reader(m_proc_path + "fd");
+    return reader.count();
+}
+
+struct fd_count_t ProcessInfo::fdTypes()
+{
+    if (m_need_update & FIELD_FD)
     {
-        readFd();
-        m_need_update_fd = false;
+        FdReader reader(m_proc_path + "fd");
+        return reader.classify();
     }
-    return m_fds;
+    // already resolved by fds()
+    struct fd_count_t counts = fd_count_t();
+    for (const std::pair<const int, std::string>& fd : m_fds)
+        FdReader::tally(counts, FdReader::typeOf(fd.second.data(), fd.second.size()));
+    return counts;
 }
 
 // from wchan
 const std::string ProcessInfo::wchanName()
 {
-    if (m_need_update_wchan)
-    {
-        readWchan();
-        m_need_update_wchan = false;
-    }
-    return m_wchan_name;
+    update(FIELD_WCHAN);
+    return cold().wchan_name;
 }
 
 // from smaps
 const std::vector<MMap>& ProcessInfo::maps()
 {
-    if (m_need_update_smaps)
+    update(FIELD_SMAPS);
+    return cold().maps;
+}
+
+// from cgroup
+const std::vector<struct cgroup_hierarchy_t>& ProcessInfo::cgroups()
+{
+    update(FIELD_CGROUP);
+    return cold().cgroups;
+}
+
+boost::string_view ProcessInfo::unifiedCgroup()
+{
+    for (const struct cgroup_hierarchy_t& cgroup : cgroups())
     {
-        readSmaps();
-        m_need_update_smaps = false;
+        // v2 is the hierarchy 0, without controllers on the line
+        if (cgroup.hierarchy_id == 0)
+            return cgroup.cgroup;
     }
-    return m_maps;
+    return boost::string_view();
+}
+
+// from limits
+const struct limits_t& ProcessInfo::limits()
+{
+    update(FIELD_LIMITS);
+    return cold().limits;
+}
+
+// from stack
+const std::vector<struct stack_func_t>& ProcessInfo::stack()
+{
+    update(FIELD_STACK);
+    return cold().stack;
+}
+
+const std::shared_ptr<StringArena>& ProcessInfo::arena() const
+{
+    return m_arena;
 }
 
 // read*
 void ProcessInfo::readCwd()
 {
-    boost::system::error_code ec;
-    this->m_cwd = boost::filesystem::read_symlink(m_proc_path + "cwd", ec).string();
+    std::string target;
+    readProcLink(m_proc_path + "cwd", target);
+    this->m_cwd = m_arena->intern(target);
 }
 
 void ProcessInfo::readExe()
 {
-    boost::system::error_code ec;
-    this->m_exe = boost::filesystem::read_symlink(m_proc_path + "exe", ec).string();
+    std::string target;
+    readProcLink(m_proc_path + "exe", target);
+    this->m_exe = m_arena->intern(target);
 }
 
 void ProcessInfo::readRoot()
 {
-    boost::system::error_code ec;
-    this->m_root = boost::filesystem::read_symlink(m_proc_path + "root", ec).string();
+    std::string target;
+    readProcLink(m_proc_path + "root", target);
+    this->m_root = m_arena->intern(target);
 }
 
 void ProcessInfo::readCmdline()
 {
-    std::ifstream if_cmdline(m_proc_path + "cmdline");
+    ProcStream if_cmdline(m_proc_path + "cmdline");
     m_cmdline.clear();
     std::string cur_arg;
     while (getline(if_cmdline, cur_arg, '\0'))
@@ -850,86 +830,77 @@ void ProcessInfo::readCmdline()
 
 void ProcessInfo::readStat()
 {
-    std::ifstream if_stat(m_proc_path + "stat");
+    // single read, the whole file fits in the buffer
+    char buf[2048];
+    ssize_t len = readProcFile(m_proc_path + "stat", buf, sizeof(buf));
+    m_stat_time = std::chrono::steady_clock::now();
+    struct proc_stat_t stat;
+    if (len <= 0 || !parseStat(buf, len, stat))
+        return; // the process is gone
     // pid
-    if_stat >> this->m_pid;
-    // name
-    if_stat >> this->m_name; // (name)
-    this->m_name.erase(std::remove(this->m_name.begin(), this->m_name.end(), '('), this->m_name.end());
-    this->m_name.erase(std::remove(this->m_name.begin(), this->m_name.end(), ')'), this->m_name.end());
+    this->m_hot.pid = stat.pid;
+    // name, may contain spaces
+    this->m_name = stat.comm;
     // status
-    std::string state;
-    if_stat >> state;
-    if (state == "R")
-        this->m_state = "Running";
-    else if (state == "S")
-        this->m_state = "Sleeping";
-    else if (state == "D")
-        this->m_state = "Disk sleep";
-    else if (state == "Z")
-        this->m_state = "Zombie";
-    else if (state == "T")
-        this->m_state = "Stopped";
-    else if (state == "W")
-        this->m_state = "Waking";
-    else
-        this->m_state = state;
-
-    if_stat >> this->m_ppid;
-    if_stat >> this->m_pgid;
-    if_stat >> this->m_session;
-    if_stat >> this->m_tty_nr;
-    if_stat >> this->m_tpgid;
-    if_stat >> this->m_flags;
-    if_stat >> this->m_minflt;
-    if_stat >> this->m_cminflt;
-    if_stat >> this->m_majflt;
-    if_stat >> this->m_cmajflt;
-    if_stat >> this->m_utime;
-    if_stat >> this->m_stime;
-    if_stat >> this->m_cutime;
-    if_stat >> this->m_cstime;
-    if_stat >> this->m_priority;
-    if_stat >> this->m_nice;
-    if_stat >> this->m_num_threads;
-    if_stat >> this->m_itrealvalue;
-    if_stat >> this->m_starttime;
-    if_stat >> this->m_vmsize;
-    if_stat >> this->m_rss;
-    if_stat >> this->m_rsslim;
-    if_stat >> this->m_startcode;
-    if_stat >> this->m_endcode;
-    if_stat >> this->m_startstack;
-    if_stat >> this->m_kstkesp;
-    if_stat >> this->m_kstkeip;
-    if_stat >> this->m_signal;
-    if_stat >> this->m_blocked;
-    if_stat >> this->m_siginore;
-    if_stat >> this->m_sigcatch;
-    if_stat >> this->m_wchan_addr;
-    if_stat >> this->m_nswap;
-    if_stat >> this->m_cnswap;
-    if_stat >> this->m_exit_signal;
-    if_stat >> this->m_processor;
-    if_stat >> this->m_rt_priority;
-    if_stat >> this->m_policy;
-    if_stat >> this->m_delayacct_blkio_ticks;
-    if_stat >> this->m_guest_time;
-    if_stat >> this->m_cguest_time;
-    if_stat >> this->m_start_data;
-    if_stat >> this->m_end_data;
-    if_stat >> this->m_start_brk;
-    if_stat >> this->m_arg_start;
-    if_stat >> this->m_arg_end;
-    if_stat >> this->m_env_start;
-    if_stat >> this->m_env_end;
-    if_stat >> this->m_exit_code;
-    if_stat.close();
+    this->m_hot.state = stat.state;
+
+    this->m_hot.ppid = statField(stat, STAT_PPID);
+    this->m_hot.pgid = statField(stat, STAT_PGRP);
+    this->m_hot.session = statField(stat, STAT_SESSION);
+    this->m_hot.tty_nr = statField(stat, STAT_TTY_NR);
+    this->m_hot.tpgid = statField(stat, STAT_TPGID);
+    this->m_hot.flags = statField(stat, STAT_FLAGS);
+    this->m_hot.minflt = statField(stat, STAT_MINFLT);
+    this->m_hot.cminflt = statField(stat, STAT_CMINFLT);
+    this->m_hot.majflt = statField(stat, STAT_MAJFLT);
+    this->m_hot.cmajflt = statField(stat, STAT_CMAJFLT);
+    this->m_hot.utime = statField(stat, STAT_UTIME);
+    this->m_hot.stime = statField(stat, STAT_STIME);
+    this->m_hot.cutime = statField(stat, STAT_CUTIME);
+    this->m_hot.cstime = statField(stat, STAT_CSTIME);
+    this->m_hot.priority = statField(stat, STAT_PRIORITY);
+    this->m_hot.nice = statField(stat, STAT_NICE);
+    this->m_hot.num_threads = statField(stat, STAT_NUM_THREADS);
+    this->m_itrealvalue = statField(stat, STAT_ITREALVALUE);
+    this->m_hot.starttime = statField(stat, STAT_STARTTIME);
+    this->m_hot.vmsize = statField(stat, STAT_VSIZE);
+    this->m_hot.rss = statField(stat, STAT_RSS);
+    this->m_rsslim = statField(stat, STAT_RSSLIM);
+    this->m_startcode = statField(stat, STAT_STARTCODE);
+    this->m_endcode = statField(stat, STAT_ENDCODE);
+    this->m_startstack = statField(stat, STAT_STARTSTACK);
+    this->m_kstkesp = statField(stat, STAT_KSTKESP);
+    this->m_kstkeip = statField(stat, STAT_KSTKEIP);
+    this->m_signal = statField(stat, STAT_SIGNAL);
+    this->m_blocked = statField(stat, STAT_BLOCKED);
+    this->m_siginore = statField(stat, STAT_SIGIGNORE);
+    this->m_sigcatch = statField(stat, STAT_SIGCATCH);
+    this->m_wchan_addr = statField(stat, STAT_WCHAN);
+    this->m_nswap = statField(stat, STAT_NSWAP);
+    this->m_cnswap = statField(stat, STAT_CNSWAP);
+    this->m_exit_signal = statField(stat, STAT_EXIT_SIGNAL);
+    this->m_hot.processor = statField(stat, STAT_PROCESSOR);
+    this->m_hot.rt_priority = statField(stat, STAT_RT_PRIORITY);
+    this->m_hot.policy = statField(stat, STAT_POLICY);
+    this->m_delayacct_blkio_ticks = statField(stat, STAT_DELAYACCT_BLKIO_TICKS);
+    this->m_guest_time = statField(stat, STAT_GUEST_TIME);
+    this->m_cguest_time = statField(stat, STAT_CGUEST_TIME);
+    this->m_start_data = statField(stat, STAT_START_DATA);
+    this->m_end_data = statField(stat, STAT_END_DATA);
+    this->m_start_brk = statField(stat, STAT_START_BRK);
+    this->m_arg_start = statField(stat, STAT_ARG_START);
+    this->m_arg_end = statField(stat, STAT_ARG_END);
+    this->m_env_start = statField(stat, STAT_ENV_START);
+    this->m_env_end = statField(stat, STAT_ENV_END);
+    this->m_exit_code = statField(stat, STAT_EXIT_CODE);
 }
 
 void ProcessInfo::readStatus()
 {
-    std::ifstream if_status(m_proc_path + "status");
+    ProcStream if_status(m_proc_path + "status");
+    m_status_time = std::chrono::steady_clock::now();
+    m_uids.clear();
+    m_gids.clear();
     std::string line;
     while (std::getline(if_status, line))
     {
@@ -1005,7 +976,7 @@ void ProcessInfo::readStatus()
             if (boost::regex_match(value, match, regex_vm))
             {
                 if (match.size() == 1 + 1)
-                    m_vm_rss = std::stoi(match[1]);
+                    m_hot.vm_rss = std::stoi(match[1]);
             }
             continue;
         }
@@ -1068,17 +1039,29 @@ void ProcessInfo::readStatus()
             if (boost::regex_match(value, match, regex_vm))
             {
                 if (match.size() == 1 + 1)
-                    m_vm_swap = std::stoi(match[1]);
+                    m_hot.vm_swap = std::stoi(match[1]);
             }
             continue;
         }
+        if (key == "voluntary_ctxt_switches")
+        {
+            m_voluntary_ctxt_switches = std::stoul(value);
+            continue;
+        }
+        if (key == "nonvoluntary_ctxt_switches")
+        {
+            m_nonvoluntary_ctxt_switches = std::stoul(value);
+            continue;
+        }
     }
     if_status.close();
 }
 
 void ProcessInfo::readEnviron()
 {
-    std::ifstream if_environ(m_proc_path + "environ");
+    ProcStream if_environ(m_proc_path + "environ");
+    std::unordered_map<std::string, std::string>& environ = cold().environ;
+    environ.clear();
     std::string cur_env;
     while (getline(if_environ, cur_env, '\0'))
     {
@@ -1088,16 +1071,16 @@ void ProcessInfo::readEnviron()
         // split on '='
         getline(stream, key, '=');
         getline(stream, value);
-        this->m_environ[key] = value;
+        environ[key] = value;
     }
     if_environ.close();
 }
 
 void ProcessInfo::readIo()
 {
-    std::ifstream if_io(m_proc_path + "io");
+    ProcStream if_io(m_proc_path + "io");
     // update time since last read
-    m_io.last_read = std::chrono::system_clock::now();
+    m_io.last_read = std::chrono::steady_clock::now();
     std::string line;
     while (getline(if_io, line))
     {
@@ -1128,48 +1111,46 @@ void ProcessInfo::readIo()
 
 void ProcessInfo::readWchan()
 {
-    std::ifstream if_wchan(m_proc_path + "wchan");
-    std::getline(if_wchan, m_wchan_name);
+    ProcStream if_wchan(m_proc_path + "wchan");
+    std::getline(if_wchan, cold().wchan_name);
     if_wchan.close();
 }
 
 void ProcessInfo::readFd()
 {
-    try {
-        boost::filesystem::path fd_dir_path(m_proc_path + "fd");
-        boost::filesystem::directory_iterator end_itr;
-        for (boost::filesystem::directory_iterator itr(fd_dir_path);
-             itr != end_itr;
-             ++itr)
-        {
-            boost::system::error_code ec;
-            boost::filesystem::path symlink = boost::filesystem::read_symlink(itr->path(), ec);
-            this->m_fds[std::stoi(itr->path().filename().string())] = symlink.string();
-        }
-    } catch (boost::filesystem::filesystem_error e) {
-        // permission denied
-    }
+    m_fds.clear();
+    FdReader reader(m_proc_path + "fd");
+    // permission denied if not open
+    reader.forEach([this](int fd, const char* target, size_t len) {
+        this->m_fds[fd].assign(target, len);
+    });
 }
 
 void ProcessInfo::readCgroup()
 {
-    std::ifstream if_cgroup(m_proc_path + "/cgroup");
+    ProcStream if_cgroup(m_proc_path + "cgroup");
+    cold().cgroups.clear();
     if (if_cgroup.is_open())
     {
-        // sample line :
+        // sample lines, v1 then v2 :
         // 5:cpuacct,cpu,cpuset:/daemons
+        // 0::/system.slice/sshd.service
         std::string line;
         while (std::getline(if_cgroup, line))
         {
             struct cgroup_hierarchy_t cgroup;
 
-            std::vector<std::string> splitted;
-            boost::split(splitted, line, boost::is_any_of(":"));
-            cgroup.hierarchy_id = std::stoi(splitted[0]);
-            boost::split(cgroup.subsystems, splitted[1], boost::is_any_of(","));
-            cgroup.cgroup = splitted[2];
-
-            this->m_cgroups.push_back(cgroup);
+            // the path itself may contain ':'
+            size_t first = line.find(':');
+            size_t second = first == std::string::npos ? first : line.find(':', first + 1);
+            if (second == std::string::npos)
+                continue;
+            cgroup.hierarchy_id = std::stoi(line.substr(0, first));
+            if (second > first + 1)
+                boost::split(cgroup.subsystems, line.substr(first + 1, second - first - 1), boost::is_any_of(","));
+            cgroup.cgroup = m_arena->view(m_arena->intern(line.substr(second + 1)));
+
+            cold().cgroups.push_back(cgroup);
         }
     }
     if_cgroup.close();
@@ -1177,8 +1158,9 @@ void ProcessInfo::readCgroup()
 
 void ProcessInfo::readSmaps()
 {
-    m_maps.clear();
-    std::ifstream if_smaps(m_proc_path + "/smaps");
+    std::vector<MMap>& maps = cold().maps;
+    maps.clear();
+    ProcStream if_smaps(m_proc_path + "smaps");
     if (if_smaps.is_open())
     {
         // line sample
@@ -1195,9 +1177,9 @@ void ProcessInfo::readSmaps()
                 if (!map_stream.str().empty())
                 {
                     // create map
-                    MMap map = MMap(map_stream);
+                    MMap map = MMap(map_stream, *m_arena);
                     // append
-                    m_maps.push_back(map);
+                    maps.push_back(map);
                     // reset stream
                     map_stream.clear();
                     map_stream.str("");
@@ -1207,15 +1189,16 @@ void ProcessInfo::readSmaps()
             map_stream << "\n";
         }
         // append last map
-        MMap map = MMap(map_stream);
-        m_maps.push_back(map);
+        MMap map = MMap(map_stream, *m_arena);
+        maps.push_back(map);
     }
     if_smaps.close();
 }
 
 void ProcessInfo::readLimits()
 {
-    std::ifstream if_limits(m_proc_path + "/limits");
+    ProcStream if_limits(m_proc_path + "limits");
+    struct limits_t& limits = cold().limits;
     if (if_limits.is_open())
     {
         // line sample
@@ -1238,68 +1221,68 @@ void ProcessInfo::readLimits()
                     boost::algorithm::trim(field_name);
                     if (field_name == "cpu time")
                     {
-                        this->m_limits.cpu_time_soft_lmt = soft_lmt;
-                        this->m_limits.cpu_time_hard_lmt = hard_lmt;
+                        limits.cpu_time_soft_lmt = soft_lmt;
+                        limits.cpu_time_hard_lmt = hard_lmt;
                     } else if (field_name == "file size")
                     {
-                        this->m_limits.file_size_soft_lmt = soft_lmt;
-                        this->m_limits.file_size_hard_lmt = hard_lmt;
+                        limits.file_size_soft_lmt = soft_lmt;
+                        limits.file_size_hard_lmt = hard_lmt;
                     } else if (field_name == "data size")
                     {
-                        this->m_limits.data_size_soft_lmt = soft_lmt;
-                        this->m_limits.data_size_hard_lmt = hard_lmt;
+                        limits.data_size_soft_lmt = soft_lmt;
+                        limits.data_size_hard_lmt = hard_lmt;
                     } else if (field_name == "stack size")
                     {
-                        this->m_limits.stack_size_soft_lmt = soft_lmt;
-                        this->m_limits.stack_size_hard_lmt = hard_lmt;
+                        limits.stack_size_soft_lmt = soft_lmt;
+                        limits.stack_size_hard_lmt = hard_lmt;
                     } else if (field_name == "core file size")
                     {
-                        this->m_limits.core_file_size_soft_lmt = soft_lmt;
-                        this->m_limits.core_file_size_hard_lmt = hard_lmt;
+                        limits.core_file_size_soft_lmt = soft_lmt;
+                        limits.core_file_size_hard_lmt = hard_lmt;
                     } else if (field_name == "resident set")
                     {
-                        this->m_limits.resident_set_soft_lmt = soft_lmt;
-                        this->m_limits.resident_set_hard_lmt = hard_lmt;
+                        limits.resident_set_soft_lmt = soft_lmt;
+                        limits.resident_set_hard_lmt = hard_lmt;
                     } else if (field_name == "processes")
                     {
-                        this->m_limits.processes_soft_lmt = soft_lmt;
-                        this->m_limits.processes_hard_lmt = hard_lmt;
+                        limits.processes_soft_lmt = soft_lmt;
+                        limits.processes_hard_lmt = hard_lmt;
                     } else if (field_name == "open files")
                     {
-                        this->m_limits.open_files_soft_lmt = soft_lmt;
-                        this->m_limits.open_files_hard_lmt = hard_lmt;
+                        limits.open_files_soft_lmt = soft_lmt;
+                        limits.open_files_hard_lmt = hard_lmt;
                     } else if (field_name == "locked memory")
                     {
-                        this->m_limits.locked_memory_soft_lmt = soft_lmt;
-                        this->m_limits.locked_memory_hard_lmt = hard_lmt;
+                        limits.locked_memory_soft_lmt = soft_lmt;
+                        limits.locked_memory_hard_lmt = hard_lmt;
                     } else if (field_name == "address space")
                     {
-                        this->m_limits.address_space_soft_lmt = soft_lmt;
-                        this->m_limits.address_space_hard_lmt = hard_lmt;
+                        limits.address_space_soft_lmt = soft_lmt;
+                        limits.address_space_hard_lmt = hard_lmt;
                     } else if (field_name == "file locks")
                     {
-                        this->m_limits.file_locks_soft_lmt = soft_lmt;
-                        this->m_limits.file_locks_hard_lmt = hard_lmt;
+                        limits.file_locks_soft_lmt = soft_lmt;
+                        limits.file_locks_hard_lmt = hard_lmt;
                     } else if (field_name == "pending signals")
                     {
-                        this->m_limits.pending_signals_soft_lmt = soft_lmt;
-                        this->m_limits.pending_signals_hard_lmt = hard_lmt;
+                        limits.pending_signals_soft_lmt = soft_lmt;
+                        limits.pending_signals_hard_lmt = hard_lmt;
                     } else if (field_name == "msgqueue size")
                     {
-                        this->m_limits.msgqueue_size_soft_lmt = soft_lmt;
-                        this->m_limits.msgqueue_size_hard_lmt = hard_lmt;
+                        limits.msgqueue_size_soft_lmt = soft_lmt;
+                        limits.msgqueue_size_hard_lmt = hard_lmt;
                     } else if (field_name == "nice priority")
                     {
-                        this->m_limits.nice_priority_soft_lmt = soft_lmt;
-                        this->m_limits.nice_priority_hard_lmt = hard_lmt;
+                        limits.nice_priority_soft_lmt = soft_lmt;
+                        limits.nice_priority_hard_lmt = hard_lmt;
                     } else if (field_name == "realtime priority")
                     {
-                        this->m_limits.realtime_priority_soft_lmt = soft_lmt;
-                        this->m_limits.realtime_priority_hard_lmt = hard_lmt;
+                        limits.realtime_priority_soft_lmt = soft_lmt;
+                        limits.realtime_priority_hard_lmt = hard_lmt;
                     } else if (field_name == "realtime timeout")
                     {
-                        this->m_limits.realtime_timeout_soft_lmt = soft_lmt;
-                        this->m_limits.realtime_timeout_hard_lmt = hard_lmt;
+                        limits.realtime_timeout_soft_lmt = soft_lmt;
+                        limits.realtime_timeout_hard_lmt = hard_lmt;
                     }
                 }
             }
@@ -1310,7 +1293,8 @@ void ProcessInfo::readLimits()
 
 void ProcessInfo::readStack()
 {
-    std::ifstream if_stack(m_proc_path + "/stack");
+    ProcStream if_stack(m_proc_path + "stack");
+    cold().stack.clear();
     if (if_stack.is_open())
     {
         std::string line;
@@ -1326,7 +1310,7 @@ void ProcessInfo::readStack()
                     func.address = match[1];
                     func.function = match[2];
 
-                    this->m_stack.push_back(func);
+                    cold().stack.push_back(func);
                 }
             }
         }
@@ -1334,95 +1318,132 @@ void ProcessInfo::readStack()
     if_stack.close();
 }
 
-// computed
-int ProcessInfo::cpuUsage()
+enum field_group counterField(enum rate_counter counter)
 {
-    if (m_need_update_cpu_usage)
+    switch (counter)
     {
-        updateCPUUsage();
-        m_need_update_cpu_usage = false;
+    case COUNTER_MINFLT:
+    case COUNTER_MAJFLT:
+    case COUNTER_UTIME:
+    case COUNTER_STIME:
+        return FIELD_STAT;
+    case COUNTER_VOLUNTARY_CTXT_SWITCHES:
+    case COUNTER_NONVOLUNTARY_CTXT_SWITCHES:
+        return FIELD_STATUS;
+    default:
+        return FIELD_IO;
     }
-    return m_cpu_usage;
 }
 
-double ProcessInfo::ioReadUsage()
+unsigned long long ProcessInfo::counter(enum rate_counter counter)
 {
-    if (m_need_update_io_read_usage)
+    update(counterField(counter));
+    switch (counter)
     {
-        updateIoReadUsage();
-        m_need_update_io_read_usage = false;
+    case COUNTER_MINFLT:
+        return m_hot.minflt;
+    case COUNTER_MAJFLT:
+        return m_hot.majflt;
+    case COUNTER_UTIME:
+        return m_hot.utime;
+    case COUNTER_STIME:
+        return m_hot.stime;
+    case COUNTER_RCHAR:
+        return m_io.rchar;
+    case COUNTER_WCHAR:
+        return m_io.wchar;
+    case COUNTER_SYSCR:
+        return m_io.syscr;
+    case COUNTER_SYSCW:
+        return m_io.syscw;
+    case COUNTER_READ_BYTES:
+        return m_io.read_bytes;
+    case COUNTER_WRITE_BYTES:
+        return m_io.write_bytes;
+    case COUNTER_CANCELLED_WRITE_BYTES:
+        return m_io.cancelled_write_bytes;
+    case COUNTER_VOLUNTARY_CTXT_SWITCHES:
+        return m_voluntary_ctxt_switches;
+    case COUNTER_NONVOLUNTARY_CTXT_SWITCHES:
+        return m_nonvoluntary_ctxt_switches;
+    default:
+        return 0;
     }
-    return m_io_read_usage;
 }
 
-double ProcessInfo::ioWriteUsage()
+std::chrono::steady_clock::time_point ProcessInfo::readTime(enum field_group group) const
 {
-    if (m_need_update_io_write_usage)
+    switch (group)
     {
-        updateIoWriteUsage();
-        m_need_update_io_write_usage = false;
+    case FIELD_STAT:
+        return m_stat_time;
+    case FIELD_STATUS:
+        return m_status_time;
+    case FIELD_IO:
+        return m_io.last_read;
+    default:
+        return std::chrono::steady_clock::time_point();
     }
-    return m_io_write_usage;
 }
 
-void ProcessInfo::updateIoReadUsage()
+// computed
+int ProcessInfo::cpuUsage()
 {
-    // get latest read_bytes
-    long unsigned int read_bytes = readBytes();
-    // get time
-    std::chrono::system_clock::time_point last_time = m_io.last_read;
-
-    double io_read_usage = 0;
-    // already inserted ?
-    if (ProcessInfo::map_pid_oldstate.find(m_pid) == map_pid_oldstate.end())
+    // the computed value follows the age of its source
+    update(FIELD_STAT);
+    if (m_need_update & NEED_UPDATE_CPU_USAGE)
     {
-        // insert
-        ProcessInfo::map_pid_oldstate[m_pid] = new ProcessInfo(*this);
+        updateCPUUsage();
+        m_need_update &= ~NEED_UPDATE_CPU_USAGE;
     }
-    else
+    return m_hot.cpu_usage;
+}
+
+double ProcessInfo::ioReadUsage()
+{
+    // the computed value follows the age of its source
+    update(FIELD_IO);
+    if (m_need_update & (NEED_UPDATE_IO_READ_USAGE | NEED_UPDATE_IO_WRITE_USAGE))
     {
-        // get old state
-        ProcessInfo* oldstate = ProcessInfo::map_pid_oldstate[m_pid];
-        // compute deltas
-        long unsigned int delta_read = read_bytes - oldstate->m_io.read_bytes;
-        std::chrono::duration<double, std::ratio<1,1>> delta_time = last_time - oldstate->m_io.last_read;
-        if (delta_time.count() != 0)
-            io_read_usage = delta_read / delta_time.count();
-
-        // update old state
-        oldstate->m_io = m_io;
+        updateIoUsage();
+        m_need_update &= ~(NEED_UPDATE_IO_READ_USAGE | NEED_UPDATE_IO_WRITE_USAGE);
     }
-    m_io_read_usage = io_read_usage;
+    return m_io_read_usage;
 }
 
-void ProcessInfo::updateIoWriteUsage()
+double ProcessInfo::ioWriteUsage()
 {
-    // get latest read_bytes
-    long unsigned int write_bytes = writeBytes();
-    // get time
-    std::chrono::system_clock::time_point last_time = m_io.last_read;
-
-    double io_write_usage = 0;
-    // already inserted ?
-    if (ProcessInfo::map_pid_oldstate.find(m_pid) == map_pid_oldstate.end())
+    // the computed value follows the age of its source
+    update(FIELD_IO);
+    if (m_need_update & (NEED_UPDATE_IO_READ_USAGE | NEED_UPDATE_IO_WRITE_USAGE))
     {
-        // insert
-        ProcessInfo::map_pid_oldstate[m_pid] = new ProcessInfo(*this);
+        updateIoUsage();
+        m_need_update &= ~(NEED_UPDATE_IO_READ_USAGE | NEED_UPDATE_IO_WRITE_USAGE);
     }
-    else
+    return m_io_write_usage;
+}
+
+void ProcessInfo::updateIoUsage()
+{
+    m_io_read_usage = 0;
+    m_io_write_usage = 0;
+    // get old state, zeroed on first insertion
+    struct oldstate_t& oldstate = ProcessInfo::map_pid_oldstate[m_hot.pid];
+    if (oldstate.has_io)
     {
-        // get old state
-        ProcessInfo* oldstate = ProcessInfo::map_pid_oldstate[m_pid];
-        // compute deltas
-        long unsigned int delta_write = write_bytes - oldstate->m_io.write_bytes;
-        std::chrono::duration<double, std::ratio<1,1>> delta_time = last_time - oldstate->m_io.last_read;
-        if (delta_time.count() != 0)
-            io_write_usage = delta_write / delta_time.count();
-
-        // update old state
-        oldstate->m_io = m_io;
+        // compute deltas, a counter going back means a new process with the same pid
+        std::chrono::duration<double> delta_time = m_io.last_read - oldstate.io.last_read;
+        if (delta_time.count() > 0)
+        {
+            if (m_io.read_bytes >= oldstate.io.read_bytes)
+                m_io_read_usage = (m_io.read_bytes - oldstate.io.read_bytes) / delta_time.count();
+            if (m_io.write_bytes >= oldstate.io.write_bytes)
+                m_io_write_usage = (m_io.write_bytes - oldstate.io.write_bytes) / delta_time.count();
+        }
     }
-    m_io_write_usage = io_write_usage;
+    // update old state
+    oldstate.has_io = true;
+    oldstate.io = m_io;
 }
 
 double ProcessInfo::ioTotalUsage()
@@ -1436,7 +1457,8 @@ void ProcessInfo::updateCPUUsage()
     int cpu_usage = 0;
 
     // read /proc/stat
-    std::ifstream if_cpu_stat("/proc/stat");
+    SourceProbe probe(SOURCE_CPU_STAT);
+    ProcStream if_cpu_stat(procPath("stat"));
     std::string tmp;
     if_cpu_stat >> tmp;
     long long unsigned user,nice,system,idle,cpu_total_time;
@@ -1452,26 +1474,23 @@ void ProcessInfo::updateCPUUsage()
     // get process_total_time
     long long unsigned process_total_time = utime() + stime();
 
-    if (ProcessInfo::map_pid_oldstate.find(m_pid) == map_pid_oldstate.end())
+    // retrieve old value, zeroed on first insertion
+    struct oldstate_t& oldstate = ProcessInfo::map_pid_oldstate[m_hot.pid];
+    if (!oldstate.has_cpu)
     {
         // insert
-        m_last_cpu_total_time = cpu_total_time;
-        m_last_process_total_time = process_total_time;
-        ProcessInfo::map_pid_oldstate[m_pid] = new ProcessInfo(*this);
+        oldstate.has_cpu = true;
     }
     else
     {
-        // retrieve old value
-        ProcessInfo* oldstate = ProcessInfo::map_pid_oldstate[m_pid];
-        long long unsigned delta_cpu_time = cpu_total_time - oldstate->m_last_cpu_total_time;
-        long long unsigned delta_process_time = process_total_time - oldstate->m_last_process_total_time;
+        long long unsigned delta_cpu_time = cpu_total_time - oldstate.cpu_total_time;
+        long long unsigned delta_process_time = process_total_time - oldstate.process_total_time;
         if (delta_cpu_time != 0)
             cpu_usage = 100 * nb_core * delta_process_time / delta_cpu_time;
-
-        // update old values
-        oldstate->m_last_cpu_total_time = cpu_total_time;
-        oldstate->m_last_process_total_time = process_total_time;
     }
+    // update old values
+    oldstate.cpu_total_time = cpu_total_time;
+    oldstate.process_total_time = process_total_time;
 
-    this->m_cpu_usage = cpu_usage;
+    this->m_hot.cpu_usage = cpu_usage;
 }
@@ -1,19 +1,22 @@
 #ifndef PROCESSINFO_H
 #define PROCESSINFO_H
 
+#include <atomic>
 #include <iostream>
 #include <map>
 #include <unordered_map>
 #include <string>
 #include <vector>
 #include <chrono>
+#include <memory>
+#include <mutex>
 
 #include <sys/types.h>
-#include <pwd.h>
 #include <linux/kdev_t.h>
 
 #include "mmap.h"
-#include "sysinfo.h"
+#include "fdreader.h"
+#include "stringarena.h"
 
 /* stolen from linux/sched.h
 * Per process flags
@@ -55,6 +58,54 @@
 #define SCHED_IDLE              5
 #define SCHED_DEADLINE          6
 
+// data sources of a ProcessInfo, one per file under /proc/<pid>/
+enum field_group
+{
+    FIELD_NONE      = 0,
+    FIELD_STAT      = 1 << 0,
+    FIELD_STATUS    = 1 << 1,
+    FIELD_IO        = 1 << 2,
+    FIELD_CMDLINE   = 1 << 3,
+    FIELD_CWD       = 1 << 4,
+    FIELD_EXE       = 1 << 5,
+    FIELD_ROOT      = 1 << 6,
+    FIELD_ENVIRON   = 1 << 7,
+    FIELD_FD        = 1 << 8,
+    FIELD_WCHAN     = 1 << 9,
+    FIELD_SMAPS     = 1 << 10,
+    FIELD_CGROUP    = 1 << 11,
+    FIELD_LIMITS    = 1 << 12,
+    FIELD_STACK     = 1 << 13,
+    FIELD_ALL       = (1 << 14) - 1
+};
+#define FIELD_GROUP_COUNT 14
+
+// monotonic counters of a process, see RateTracker
+enum rate_counter
+{
+    // from stat
+    COUNTER_MINFLT,
+    COUNTER_MAJFLT,
+    COUNTER_UTIME,
+    COUNTER_STIME,
+    // from io
+    COUNTER_RCHAR,
+    COUNTER_WCHAR,
+    COUNTER_SYSCR,
+    COUNTER_SYSCW,
+    COUNTER_READ_BYTES,
+    COUNTER_WRITE_BYTES,
+    COUNTER_CANCELLED_WRITE_BYTES,
+    // from status
+    COUNTER_VOLUNTARY_CTXT_SWITCHES,
+    COUNTER_NONVOLUNTARY_CTXT_SWITCHES,
+    COUNTER_COUNT
+};
+#define COUNTER_ALL ((1u << COUNTER_COUNT) - 1)
+
+// field_group holding counter
+enum field_group counterField(enum rate_counter counter);
+
 struct io_stat
 {
     /* characters read */
@@ -78,15 +129,16 @@ struct io_stat
      * write_bytes) will not be happening.
     */
     long unsigned int cancelled_write_bytes;
-    // time when we last read the file
-    std::chrono::system_clock::time_point last_read;
+    // CLOCK_MONOTONIC time when we last read the file
+    std::chrono::steady_clock::time_point last_read;
 };
 
 struct cgroup_hierarchy_t
 {
     int hierarchy_id;
     std::vector<std::string> subsystems;
-    std::string cgroup;
+    // interned in the ProcessInfo arena
+    boost::string_view cgroup;
 
 };
 
@@ -140,11 +192,33 @@ class ProcessInfo
 
 public:
     ProcessInfo();
-    ProcessInfo(pid_t pid);
-    ProcessInfo(const ProcessInfo& pinfo) = default;
+    // fields is a mask of field_group read right away, the other groups
+    // are read on first access
+    // strings are interned in arena, a new one is created if none is given
+    ProcessInfo(pid_t pid,
+                unsigned int fields = FIELD_NONE,
+                const std::shared_ptr<StringArena>& arena = std::shared_ptr<StringArena>());
+    // move only, a snapshot is transferred and never duplicated
+    ProcessInfo(const ProcessInfo& pinfo) = delete;
+    ProcessInfo& operator=(const ProcessInfo& pinfo) = delete;
+    ProcessInfo(ProcessInfo&& pinfo) = default;
+    ProcessInfo& operator=(ProcessInfo&& pinfo) = default;
     ~ProcessInfo();
 
     void needUpdate();
+    // read the dirty groups of the fields mask
+    void update(unsigned int fields);
+
+    // once a group is older than max_age, the getters read it again
+    // without waiting for needUpdate(), zero disables it (default)
+    void setMaxAge(unsigned int fields, std::chrono::milliseconds max_age);
+    std::chrono::milliseconds maxAge(enum field_group group) const;
+    // max age given to the ProcessInfo created afterwards
+    static void setDefaultMaxAge(unsigned int fields, std::chrono::milliseconds max_age);
+
+    // number of times each file has been read, by all the ProcessInfo
+    static unsigned long readCount(enum field_group group);
+    static void resetReadCounts();
 
     // getters
     // from stat
@@ -155,6 +229,8 @@ public:
     int pgid();
     int sid();
     const std::string ttyNr();
+    // device number of the controlling terminal, 0 if none
+    int ttyDevice();
     int tpgid();
     unsigned int flags();
     long unsigned int minflt();
@@ -169,7 +245,11 @@ public:
     long int nice();
     long int numThreads();
     long long unsigned int startTime();
+    // clock ticks after boot, constant for a process unlike startTime()
+    long long unsigned int startTicks();
     long unsigned int vmSize();
+    // resident pages, vmRss() without reading status
+    long int rss();
     long unsigned int startCode();
     long unsigned int endCode();
     long unsigned int startStack();
@@ -205,18 +285,20 @@ public:
     long unsigned int vmPte();
     long unsigned int vmPmd();
     long unsigned int vmSwap();
+    long unsigned int voluntaryCtxtSwitches();
+    long unsigned int nonvoluntaryCtxtSwitches();
 
     // from cmdline
     const std::vector<std::string>& cmdline();
 
     // from cwd
-    const std::string cwd();
+    boost::string_view cwd();
 
     // from exe
-    const std::string exe();
+    boost::string_view exe();
 
     // from root
-    const std::string root();
+    boost::string_view root();
 
     // from environ
     const std::unordered_map<std::string, std::string> environ();
@@ -225,8 +307,11 @@ public:
     long unsigned int readBytes();
     long unsigned int writeBytes();
 
-    // from fd/
-    const std::unordered_map<int, std::string>& fds();
+    // from fd/, the views are valid until the next read of the fds
+    std::unordered_map<int, boost::string_view> fds();
+    // without storing the link targets
+    long fdCount();
+    struct fd_count_t fdTypes();
 
     // from wchan
     const std::string wchanName();
@@ -234,16 +319,109 @@ public:
     // from smaps
     const std::vector<MMap>& maps();
 
+    // from cgroup
+    const std::vector<struct cgroup_hierarchy_t>& cgroups();
+    // path in the cgroup v2 hierarchy, empty without one
+    boost::string_view unifiedCgroup();
+
+    // from limits
+    const struct limits_t& limits();
+
+    // from stack
+    const std::vector<struct stack_func_t>& stack();
+
+    // any monotonic counter, reads its group if needed
+    unsigned long long counter(enum rate_counter counter);
+    // CLOCK_MONOTONIC time of the last read of FIELD_STAT, FIELD_STATUS or
+    // FIELD_IO, taken right after the file was read
+    std::chrono::steady_clock::time_point readTime(enum field_group group) const;
+
     // computed
     int cpuUsage();
     double ioReadUsage();
     double ioWriteUsage();
     double ioTotalUsage();
     const std::string userName();
+    const std::string groupName();
+
+    const std::shared_ptr<StringArena>& arena() const;
 
 private:
+    // previous sample of the computed values
+    struct oldstate_t
+    {
+        bool has_cpu;
+        long long unsigned cpu_total_time;
+        long long unsigned process_total_time;
+        bool has_io;
+        struct io_stat io;
+    };
+
+    // frequently read scalars, kept together at the start of the object
+    struct hot_t
+    {
+        pid_t pid;
+        pid_t ppid;
+        pid_t pgid;
+        int session;
+        int tty_nr;
+        int tpgid;
+        int processor;
+        // R, S, D, ...
+        char state;
+        unsigned int flags;
+        unsigned int rt_priority;
+        unsigned int policy;
+        long int priority;
+        long int nice;
+        long int num_threads;
+        long unsigned int minflt;
+        long unsigned int cminflt;
+        long unsigned int majflt;
+        long unsigned int cmajflt;
+        long unsigned int utime;
+        long unsigned int stime;
+        long unsigned int cutime;
+        long unsigned int cstime;
+        long long unsigned int starttime;
+        long unsigned int vmsize;
+        long int rss;
+        long unsigned int vm_rss;
+        long unsigned int vm_swap;
+        int cpu_usage;
+    };
+
+    // rarely used data, allocated on first access
+    struct cold_t
+    {
+        std::unordered_map<std::string, std::string> environ;
+        std::string wchan_name;
+        std::vector<struct cgroup_hierarchy_t> cgroups;
+        std::vector<MMap> maps;
+        struct limits_t limits;
+        std::vector<struct stack_func_t> stack;
+    };
+
+    // refresh policy, allocated by setMaxAge()
+    struct aging_t
+    {
+        std::chrono::milliseconds max_age[FIELD_GROUP_COUNT];
+        std::chrono::steady_clock::time_point read_time[FIELD_GROUP_COUNT];
+    };
+
     // static
-    static std::unordered_map<int, ProcessInfo*> map_pid_oldstate;
+    static std::unordered_map<int, struct oldstate_t> map_pid_oldstate;
+    static std::atomic<unsigned long> s_read_count[FIELD_GROUP_COUNT];
+    static std::chrono::milliseconds s_default_max_age[FIELD_GROUP_COUNT];
+    static std::mutex s_default_max_age_mutex;
+
+    // m_need_update bits for the computed values, after the field groups
+    enum computed_update
+    {
+        NEED_UPDATE_CPU_USAGE       = 1 << 16,
+        NEED_UPDATE_IO_READ_USAGE   = 1 << 17,
+        NEED_UPDATE_IO_WRITE_USAGE  = 1 << 18
+    };
 
     // functions
     void readCwd();
@@ -262,54 +440,34 @@ private:
     void readStack();
 
     void updateCPUUsage();
-    void updateIoReadUsage();
-    void updateIoWriteUsage();
+    // both rates at once, against the same previous sample
+    void updateIoUsage();
+
+    struct cold_t& cold();
+    struct aging_t& aging();
 
     // friend
     friend std::ostream & operator<<(std::ostream &os, ProcessInfo& p);
 
     // properties
-    std::string m_proc_path;
-    bool m_need_update_stat;
-    bool m_need_update_status;
-    bool m_need_update_io;
-    bool m_need_update_cwd;
-    bool m_need_update_exe;
-    bool m_need_update_cmdline;
-    bool m_need_update_root;
-    bool m_need_update_environ;
-    bool m_need_update_fd;
-    bool m_need_update_wchan;
-    bool m_need_update_smaps;
-    bool m_need_update_cpu_usage;
-    bool m_need_update_io_read_usage;
-    bool m_need_update_io_write_usage;
+    struct hot_t m_hot;
+    // from io
+    struct io_stat m_io;
+    // field_group and computed_update bits
+    unsigned int m_need_update;
+    // groups with a max age
+    unsigned int m_max_age_fields;
+    double m_io_read_usage;
+    double m_io_write_usage;
 
-    // from stat
-    pid_t m_pid;
     std::string m_name;
-    std::string m_state;
-    pid_t m_ppid;
-    pid_t m_pgid;
-    int m_session;
-    int m_tty_nr;
-    int m_tpgid;
-    unsigned int m_flags;
-    long unsigned int m_minflt;
-    long unsigned int m_cminflt;
-    long unsigned int m_majflt;
-    long unsigned int m_cmajflt;
-    long unsigned int m_utime;
-    long unsigned int m_stime;
-    long unsigned int m_cutime;
-    long unsigned int m_cstime;
-    long int m_priority;
-    long int m_nice;
-    long int m_num_threads;
+    std::string m_proc_path;
+    std::shared_ptr<StringArena> m_arena;
+    std::unique_ptr<struct cold_t> m_cold;
+    std::unique_ptr<struct aging_t> m_aging;
+
+    // from stat, rarely used
     long int m_itrealvalue;
-    long long unsigned int m_starttime;
-    long unsigned int m_vmsize;
-    long int m_rss;
     long unsigned int m_rsslim;
     long unsigned int m_startcode;
     long unsigned int m_endcode;
@@ -324,9 +482,7 @@ private:
     long unsigned int m_nswap;
     long unsigned int m_cnswap;
     int m_exit_signal;
-    int m_processor;
-    unsigned int m_rt_priority;
-    unsigned int m_policy;
+    int m_exit_code;
     long long unsigned int m_delayacct_blkio_ticks;
     long unsigned int m_start_data;
     long unsigned int m_end_data;
@@ -335,24 +491,17 @@ private:
     long unsigned int m_arg_end;
     long unsigned int m_env_start;
     long unsigned int m_env_end;
-    int m_exit_code;
     long unsigned int m_guest_time;
     long int m_cguest_time;
 
     // from cmdline
     std::vector<std::string> m_cmdline;
     // from cwd
-    std::string m_cwd;
+    StringArena::handle_t m_cwd;
     // from exe
-    std::string m_exe;
+    StringArena::handle_t m_exe;
     // from root
-    std::string m_root;
-    // from environ
-    std::unordered_map<std::string, std::string> m_environ;
-    // from io
-    struct io_stat m_io;
-    // from wchan
-    std::string m_wchan_name;
+    StringArena::handle_t m_root;
     // from status
     pid_t m_tracerpid;
     std::vector<int> m_uids;
@@ -361,75 +510,20 @@ private:
     long unsigned int m_vm_lck;
     long unsigned int m_vm_pin;
     long unsigned int m_vm_hwm;
-    long unsigned int m_vm_rss;
     long unsigned int m_vm_data;
     long unsigned int m_vm_stk;
     long unsigned int m_vm_exe;
     long unsigned int m_vm_lib;
     long unsigned int m_vm_pte;
     long unsigned int m_vm_pmd;
-    long unsigned int m_vm_swap;
+    long unsigned int m_voluntary_ctxt_switches;
+    long unsigned int m_nonvoluntary_ctxt_switches;
+    std::chrono::steady_clock::time_point m_stat_time;
+    std::chrono::steady_clock::time_point m_status_time;
 
-    // from cgroup
-    std::vector<struct cgroup_hierarchy_t> m_cgroups;
-    // from fd
+    // from fd, not interned: socket:[N], pipe:[N]... are unique to the
+    // process and would only grow the arena on every refresh
     std::unordered_map<int, std::string> m_fds;
-    // from smaps
-    std::vector<MMap> m_maps;
-    // from limits
-    struct limits_t m_limits;
-    // from stack
-    std::vector<struct stack_func_t> m_stack;
-    // computed
-    int m_cpu_usage;
-    double m_io_read_usage;
-    double m_io_write_usage;
-
-    // old
-    long long unsigned m_last_cpu_total_time;
-    long long unsigned m_last_process_total_time;
-
-
-    /**
-      The nice level. The range should be -20 to 20. I'm not sure
-      whether this is true for all platforms.
-      /
-    int m_niceLevel;
-
-    /** The i/o scheduling class and priority. */
-    int m_ioPriorityClass;  /**< 0 for none, 1 for realtime, 2 for best-effort, 3 for idle.  -1 for error. */
-    int m_ioPriority;       /**< Between 0 and 7.  0 is highest priority, 7 is lowest.  -1 for error. */
-
-    /**
-      The amount of physical memory the process currently uses, including the physical memory used by any
-      shared libraries that it uses.  Hence 2 processes sharing a library will both report their vmRss as including
-      this shared memory, even though it's only allocated once.
-
-      This is in KiB
-     */
-
-    unsigned long m_vmRss;
-
-    /** The amount of physical memory that is used by this process, not including any memory used by any shared libraries.
-     *  This is in KiB */
-    unsigned long m_vmURss;
-
-    /**
-      The number of 1/100 of a second the process has spend in user space.
-      If a machine has an uptime of 1 1/2 years or longer this is not a
-      good idea. I never thought that the stability of UNIX could get me
-      into trouble! ;)
-     */
-    unsigned long m_userTime;
-
-    /**
-      The number of 1/100 of a second the process has spent in system space.
-      If a machine has an uptime of 1 1/2 years or longer this is not a
-      good idea. I never thought that the stability of UNIX could get me
-      into trouble! ;)
-     */
-    unsigned long m_sysTime;
-
 };
 
 #endif // PROCESSINFO_H
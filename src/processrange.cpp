@@ -0,0 +1,127 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "processrange.h"
+#include "procbackend.h"
+
+ProcessRange::ProcessRange(unsigned int fields, const std::shared_ptr<StringArena>& arena)
+    : m_fields(fields), m_arena(arena), m_dir_fd(-1), m_next_name(0), m_done(false)
+{
+    if (procBackend().isLive())
+    {
+        m_dir_fd = open(procRoot().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        m_entries.reset(new NumericEntryStream(m_dir_fd));
+    }
+    else
+    {
+        procBackend().listDir(procRoot(), m_names);
+    }
+}
+
+ProcessRange::~ProcessRange()
+{
+    if (m_dir_fd != -1)
+        close(m_dir_fd);
+}
+
+size_t ProcessRange::sizeHint() const
+{
+    if (!m_entries)
+        return m_names.size();
+    // another fd, the position of the range is kept
+    int dir_fd = open(procRoot().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    size_t count = 0;
+    forEachNumericEntry(dir_fd, [&count](int, const char*) { count++; });
+    if (dir_fd != -1)
+        close(dir_fd);
+    return count;
+}
+
+ProcessRange::iterator ProcessRange::begin()
+{
+    if (m_done || !advance())
+        return iterator();
+    return iterator(this);
+}
+
+ProcessRange::iterator ProcessRange::end()
+{
+    return iterator();
+}
+
+bool ProcessRange::nextPid(pid_t& pid)
+{
+    if (m_entries)
+    {
+        const char* name;
+        return m_entries->next(pid, name);
+    }
+    while (m_next_name < m_names.size())
+    {
+        const std::string& name = m_names[m_next_name++];
+        // only the process directories are named by a number
+        if (name.empty() || name.find_first_not_of("0123456789") != std::string::npos)
+            continue;
+        pid = std::stoi(name);
+        return true;
+    }
+    return false;
+}
+
+bool ProcessRange::advance()
+{
+    pid_t pid;
+    while (nextPid(pid))
+    {
+        try {
+            m_current = ProcessInfo(pid, m_fields, m_arena);
+            return true;
+        } catch (const std::string& e)
+        {
+            continue;
+        }
+        catch (const std::ios_base::failure& e) // the process died while we tried to read a file
+        {
+            continue;
+        }
+    }
+    m_done = true;
+    return false;
+}
+
+ProcessRange::iterator::iterator()
+    : m_range(nullptr)
+{
+}
+
+ProcessRange::iterator::iterator(ProcessRange* range)
+    : m_range(range)
+{
+}
+
+ProcessInfo& ProcessRange::iterator::operator*() const
+{
+    return m_range->m_current;
+}
+
+ProcessInfo* ProcessRange::iterator::operator->() const
+{
+    return &m_range->m_current;
+}
+
+ProcessRange::iterator& ProcessRange::iterator::operator++()
+{
+    if (!m_range->advance())
+        m_range = nullptr;
+    return *this;
+}
+
+bool ProcessRange::iterator::operator==(const iterator& other) const
+{
+    return m_range == other.m_range;
+}
+
+bool ProcessRange::iterator::operator!=(const iterator& other) const
+{
+    return m_range != other.m_range;
+}
@@ -0,0 +1,85 @@
+#ifndef PROCESSRANGE_H
+#define PROCESSRANGE_H
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "processinfo.h"
+#include "procfs.h"
+
+// Lazy scan of the running processes
+//
+// The process directories are enumerated while iterating and each process
+// is read only when the iterator reaches it, so the first one is available
+// right away and breaking out of the loop stops the scan. Only the current
+// ProcessInfo is kept, it can be moved out of the range by the caller.
+//
+//   for (ProcessInfo& pinfo : ProcessRange(FIELD_STAT))
+//       if (pinfo.name() == "sshd")
+//           break;
+//
+// A range is single pass, like an input stream.
+class ProcessRange
+{
+public:
+    // fields is a mask of field_group read for each process
+    // strings are interned in arena, one per process if none is given
+    explicit ProcessRange(unsigned int fields = FIELD_NONE,
+                          const std::shared_ptr<StringArena>& arena = std::shared_ptr<StringArena>());
+    ~ProcessRange();
+
+    ProcessRange(const ProcessRange&) = delete;
+    ProcessRange& operator=(const ProcessRange&) = delete;
+
+    class iterator
+    {
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef ProcessInfo value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef ProcessInfo* pointer;
+        typedef ProcessInfo& reference;
+
+        // end of the range
+        iterator();
+        explicit iterator(ProcessRange* range);
+
+        ProcessInfo& operator*() const;
+        ProcessInfo* operator->() const;
+        iterator& operator++();
+        bool operator==(const iterator& other) const;
+        bool operator!=(const iterator& other) const;
+
+    private:
+        ProcessRange* m_range;
+    };
+
+    // number of process directories, counted by a separate getdents pass
+    // which does not read any process, to reserve the storage
+    size_t sizeHint() const;
+
+    // reads the first process
+    iterator begin();
+    iterator end();
+
+private:
+    // reads the next process still alive, false at the end
+    bool advance();
+    bool nextPid(pid_t& pid);
+
+    unsigned int m_fields;
+    std::shared_ptr<StringArena> m_arena;
+    // live system, directory read with getdents64
+    int m_dir_fd;
+    std::unique_ptr<NumericEntryStream> m_entries;
+    // other backends, listed at once
+    std::vector<std::string> m_names;
+    size_t m_next_name;
+    bool m_done;
+    ProcessInfo m_current;
+};
+
+#endif // PROCESSRANGE_H
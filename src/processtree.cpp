@@ -0,0 +1,341 @@
+#include <unistd.h>
+
+#include "processtree.h"
+
+namespace {
+
+void accumulate(struct tree_usage_t& to, const struct tree_usage_t& from, int sign)
+{
+    to.cpu += sign * from.cpu;
+    to.rss += sign * from.rss;
+    to.pss += sign * from.pss;
+    to.io_bytes += sign * from.io_bytes;
+    to.threads += sign * from.threads;
+    to.processes += sign * from.processes;
+}
+
+} // namespace
+
+ProcessTree::ProcessTree()
+    : m_fields(FIELD_STAT), m_first_root(-1)
+{
+}
+
+ProcessTree::ProcessTree(std::vector<ProcessInfo>& processes, unsigned int fields)
+    : m_fields(fields), m_first_root(-1)
+{
+    build(processes, fields);
+}
+
+void ProcessTree::build(std::vector<ProcessInfo>& processes, unsigned int fields)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_fields = fields;
+    m_nodes.clear();
+    m_free.clear();
+    m_index.clear();
+    m_first_root = -1;
+    m_nodes.reserve(processes.size());
+    m_index.reserve(processes.size());
+
+    // index every process first, a parent can come after its children
+    std::vector<pid_t> ppids;
+    ppids.reserve(processes.size());
+    for (ProcessInfo& pinfo : processes)
+    {
+        if (find(pinfo.pid()) != -1)
+            continue;
+        addNode(pinfo.pid(), usageOf(pinfo));
+        ppids.push_back(pinfo.ppid());
+    }
+    for (size_t i = 0; i < m_nodes.size(); i++)
+    {
+        int parent = find(ppids[i]);
+        link(i, parent == static_cast<int>(i) ? -1 : parent);
+    }
+
+    // parents before their children, then sum from the leaves up
+    std::vector<int> order;
+    order.reserve(m_nodes.size());
+    for (int node = m_first_root; node != -1; node = m_nodes[node].next_sibling)
+        order.push_back(node);
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        for (int child = m_nodes[order[i]].first_child; child != -1; child = m_nodes[child].next_sibling)
+            order.push_back(child);
+    }
+    for (std::vector<int>::reverse_iterator it = order.rbegin(); it != order.rend(); ++it)
+    {
+        int parent = m_nodes[*it].parent;
+        if (parent != -1)
+            accumulate(m_nodes[parent].subtree, m_nodes[*it].subtree, 1);
+    }
+}
+
+void ProcessTree::update(ProcessInfo& pinfo)
+{
+    struct tree_usage_t usage = usageOf(pinfo);
+    pid_t ppid = pinfo.ppid();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int node = find(pinfo.pid());
+    if (node == -1)
+    {
+        node = addNode(pinfo.pid(), usage);
+        int parent = find(ppid);
+        link(node, parent);
+        propagate(parent, usage, 1);
+        return;
+    }
+
+    struct tree_usage_t delta = usage;
+    accumulate(delta, m_nodes[node].self, -1);
+    m_nodes[node].self = usage;
+    propagate(node, delta, 1);
+
+    // reparented since the last update, unless it would create a cycle
+    int parent = find(ppid);
+    if (parent == m_nodes[node].parent)
+        return;
+    for (int ancestor = parent; ancestor != -1; ancestor = m_nodes[ancestor].parent)
+    {
+        if (ancestor == node)
+            return;
+    }
+    propagate(m_nodes[node].parent, m_nodes[node].subtree, -1);
+    unlink(node);
+    link(node, parent);
+    propagate(parent, m_nodes[node].subtree, 1);
+}
+
+void ProcessTree::onEvent(const struct proc_event& event)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    switch (event.what)
+    {
+    case proc_event::PROC_EVENT_FORK:
+    {
+        pid_t child_pid = event.event_data.fork.child_pid;
+        pid_t child_tgid = event.event_data.fork.child_tgid;
+        struct tree_usage_t usage = tree_usage_t();
+        usage.threads = 1;
+        if (child_pid != child_tgid)
+        {
+            // new thread
+            int node = find(child_tgid);
+            if (node == -1)
+                return;
+            accumulate(m_nodes[node].self, usage, 1);
+            propagate(node, usage, 1);
+            return;
+        }
+        if (find(child_tgid) != -1)
+            return;
+        // the usage is known after the next update()
+        usage.processes = 1;
+        int node = addNode(child_tgid, usage);
+        int parent = find(event.event_data.fork.parent_tgid);
+        link(node, parent);
+        propagate(parent, usage, 1);
+        break;
+    }
+    case proc_event::PROC_EVENT_EXIT:
+    {
+        int node = find(event.event_data.exit.process_tgid);
+        if (node == -1)
+            return;
+        if (event.event_data.exit.process_pid == event.event_data.exit.process_tgid)
+        {
+            removeNode(node);
+            return;
+        }
+        struct tree_usage_t usage = tree_usage_t();
+        usage.threads = 1;
+        accumulate(m_nodes[node].self, usage, -1);
+        propagate(node, usage, -1);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+size_t ProcessTree::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_index.size();
+}
+
+bool ProcessTree::contains(pid_t pid) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return find(pid) != -1;
+}
+
+pid_t ProcessTree::parent(pid_t pid) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int node = find(pid);
+    if (node == -1 || m_nodes[node].parent == -1)
+        return 0;
+    return m_nodes[m_nodes[node].parent].pid;
+}
+
+std::vector<pid_t> ProcessTree::children(pid_t pid) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<pid_t> pids;
+    int node = find(pid);
+    if (node == -1)
+        return pids;
+    for (int child = m_nodes[node].first_child; child != -1; child = m_nodes[child].next_sibling)
+        pids.push_back(m_nodes[child].pid);
+    return pids;
+}
+
+std::vector<pid_t> ProcessTree::roots() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<pid_t> pids;
+    for (int node = m_first_root; node != -1; node = m_nodes[node].next_sibling)
+        pids.push_back(m_nodes[node].pid);
+    return pids;
+}
+
+std::vector<pid_t> ProcessTree::subtree(pid_t pid) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<pid_t> pids;
+    int node = find(pid);
+    if (node == -1)
+        return pids;
+    std::vector<int> order(1, node);
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        pids.push_back(m_nodes[order[i]].pid);
+        for (int child = m_nodes[order[i]].first_child; child != -1; child = m_nodes[child].next_sibling)
+            order.push_back(child);
+    }
+    return pids;
+}
+
+struct tree_usage_t ProcessTree::usage(pid_t pid) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int node = find(pid);
+    return node == -1 ? tree_usage_t() : m_nodes[node].self;
+}
+
+struct tree_usage_t ProcessTree::subtreeUsage(pid_t pid) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int node = find(pid);
+    return node == -1 ? tree_usage_t() : m_nodes[node].subtree;
+}
+
+struct tree_usage_t ProcessTree::usageOf(ProcessInfo& pinfo) const
+{
+    static const long page_kb = sysconf(_SC_PAGESIZE) / 1024;
+    struct tree_usage_t usage = tree_usage_t();
+    usage.processes = 1;
+    if (m_fields & FIELD_STAT)
+    {
+        usage.cpu = pinfo.cpuUsage();
+        usage.rss = pinfo.rss() * page_kb;
+        usage.threads = pinfo.numThreads();
+    }
+    if (m_fields & FIELD_IO)
+        usage.io_bytes = pinfo.readBytes() + pinfo.writeBytes();
+    if (m_fields & FIELD_SMAPS)
+    {
+        for (const MMap& map : pinfo.maps())
+            usage.pss += map.pss();
+    }
+    return usage;
+}
+
+int ProcessTree::find(pid_t pid) const
+{
+    std::unordered_map<pid_t, int>::const_iterator it = m_index.find(pid);
+    return it == m_index.end() ? -1 : it->second;
+}
+
+int ProcessTree::addNode(pid_t pid, const struct tree_usage_t& self)
+{
+    int node;
+    if (m_free.empty())
+    {
+        node = m_nodes.size();
+        m_nodes.emplace_back();
+    }
+    else
+    {
+        node = m_free.back();
+        m_free.pop_back();
+    }
+    struct node_t& entry = m_nodes[node];
+    entry.pid = pid;
+    entry.parent = -1;
+    entry.first_child = -1;
+    entry.prev_sibling = -1;
+    entry.next_sibling = -1;
+    entry.self = self;
+    entry.subtree = self;
+    m_index[pid] = node;
+    return node;
+}
+
+void ProcessTree::removeNode(int node)
+{
+    propagate(m_nodes[node].parent, m_nodes[node].subtree, -1);
+    unlink(node);
+
+    // the orphans go to init, as the kernel does without a subreaper
+    int init = find(1);
+    if (init == node)
+        init = -1;
+    while (m_nodes[node].first_child != -1)
+    {
+        int child = m_nodes[node].first_child;
+        unlink(child);
+        link(child, init);
+        propagate(init, m_nodes[child].subtree, 1);
+    }
+
+    m_index.erase(m_nodes[node].pid);
+    m_nodes[node].pid = 0;
+    m_free.push_back(node);
+}
+
+void ProcessTree::link(int node, int parent)
+{
+    int& head = parent == -1 ? m_first_root : m_nodes[parent].first_child;
+    m_nodes[node].parent = parent;
+    m_nodes[node].prev_sibling = -1;
+    m_nodes[node].next_sibling = head;
+    if (head != -1)
+        m_nodes[head].prev_sibling = node;
+    head = node;
+}
+
+void ProcessTree::unlink(int node)
+{
+    struct node_t& entry = m_nodes[node];
+    if (entry.prev_sibling != -1)
+        m_nodes[entry.prev_sibling].next_sibling = entry.next_sibling;
+    else if (entry.parent == -1)
+        m_first_root = entry.next_sibling;
+    else
+        m_nodes[entry.parent].first_child = entry.next_sibling;
+    if (entry.next_sibling != -1)
+        m_nodes[entry.next_sibling].prev_sibling = entry.prev_sibling;
+    entry.parent = -1;
+    entry.prev_sibling = -1;
+    entry.next_sibling = -1;
+}
+
+void ProcessTree::propagate(int node, const struct tree_usage_t& usage, int sign)
+{
+    for (; node != -1; node = m_nodes[node].parent)
+        accumulate(m_nodes[node].subtree, usage, sign);
+}
@@ -0,0 +1,99 @@
+#ifndef PROCESSTREE_H
+#define PROCESSTREE_H
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <linux/cn_proc.h>
+#include <sys/types.h>
+
+#include "processinfo.h"
+
+// resources of a process, or of a process and its descendants
+struct tree_usage_t
+{
+    // cpuUsage(), in % of one cpu
+    double cpu;
+    // kB
+    long rss;
+    long pss;
+    // read_bytes + write_bytes
+    long long io_bytes;
+    long threads;
+    long processes;
+};
+
+// Parent / child index over a snapshot, with the usage of each subtree
+//
+// The tree is built in linear time: the nodes are indexed by pid, linked
+// to their parent through intrusive child lists, and the subtree usage is
+// summed in one pass from the leaves up. Afterwards the fork and exit
+// events of a ProcConnector, and update() of single processes, only walk
+// the ancestors of the process they change.
+//
+//   connector.addCallback([&tree](struct proc_event event) { tree.onEvent(event); });
+//
+// The tree locks itself, the events can come from the connector thread.
+class ProcessTree
+{
+public:
+    ProcessTree();
+    // fields is the mask of groups summed, FIELD_STAT for cpu, rss and the
+    // threads, FIELD_IO for io_bytes, FIELD_SMAPS for pss
+    ProcessTree(std::vector<ProcessInfo>& processes, unsigned int fields = FIELD_STAT);
+
+    // replaces the whole tree
+    void build(std::vector<ProcessInfo>& processes, unsigned int fields = FIELD_STAT);
+
+    // new usage of one process, added if unknown
+    void update(ProcessInfo& pinfo);
+    // PROC_EVENT_FORK and PROC_EVENT_EXIT, the other events are ignored
+    void onEvent(const struct proc_event& event);
+
+    size_t size() const;
+    bool contains(pid_t pid) const;
+    // 0 for a root or an unknown process
+    pid_t parent(pid_t pid) const;
+    std::vector<pid_t> children(pid_t pid) const;
+    std::vector<pid_t> roots() const;
+    // pid and its descendants, parents before their children
+    std::vector<pid_t> subtree(pid_t pid) const;
+
+    // zero for an unknown process
+    struct tree_usage_t usage(pid_t pid) const;
+    struct tree_usage_t subtreeUsage(pid_t pid) const;
+
+private:
+    struct node_t
+    {
+        pid_t pid;
+        // node indexes, -1 for none
+        int parent;
+        int first_child;
+        int prev_sibling;
+        int next_sibling;
+        struct tree_usage_t self;
+        struct tree_usage_t subtree;
+    };
+
+    struct tree_usage_t usageOf(ProcessInfo& pinfo) const;
+    int find(pid_t pid) const;
+    int addNode(pid_t pid, const struct tree_usage_t& self);
+    void removeNode(int node);
+    // parent -1 for the roots
+    void link(int node, int parent);
+    void unlink(int node);
+    // adds sign * usage to node and its ancestors
+    void propagate(int node, const struct tree_usage_t& usage, int sign);
+
+    mutable std::mutex m_mutex;
+    unsigned int m_fields;
+    std::vector<struct node_t> m_nodes;
+    // slots of the exited processes
+    std::vector<int> m_free;
+    std::unordered_map<pid_t, int> m_index;
+    int m_first_root;
+};
+
+#endif // PROCESSTREE_H
@@ -0,0 +1,161 @@
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "procfs.h"
+
+// layout returned by getdents64, not exposed by every libc
+struct linux_dirent64
+{
+    ino64_t d_ino;
+    off64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+static std::string& procRootStorage()
+{
+    static std::string root("/proc");
+    return root;
+}
+
+static std::string& devRootStorage()
+{
+    static std::string root("/dev");
+    return root;
+}
+
+static std::string& cgroupRootStorage()
+{
+    static std::string root;
+    return root;
+}
+
+// without trailing '/', the paths are built by appending "/name"
+static std::string trimRoot(const std::string& root)
+{
+    std::string trimmed(root);
+    while (trimmed.size() > 1 && trimmed.back() == '/')
+        trimmed.pop_back();
+    return trimmed;
+}
+
+void setProcRoot(const std::string& root)
+{
+    procRootStorage() = trimRoot(root);
+}
+
+const std::string& procRoot()
+{
+    return procRootStorage();
+}
+
+std::string procPath(const std::string& relative)
+{
+    return procRootStorage() + "/" + relative;
+}
+
+void setDevRoot(const std::string& root)
+{
+    devRootStorage() = trimRoot(root);
+}
+
+const std::string& devRoot()
+{
+    return devRootStorage();
+}
+
+void setCgroupRoot(const std::string& root)
+{
+    cgroupRootStorage() = trimRoot(root);
+}
+
+const std::string& cgroupRoot()
+{
+    std::string& root = cgroupRootStorage();
+    if (root.empty())
+    {
+        // cgroup.controllers only exists in a v2 hierarchy
+        if (access("/sys/fs/cgroup/unified/cgroup.controllers", F_OK) == 0)
+            root = "/sys/fs/cgroup/unified";
+        else
+            root = "/sys/fs/cgroup";
+    }
+    return root;
+}
+
+ssize_t readFileAt(int dir_fd, const char* path, char* buf, size_t size)
+{
+    int fd = openat(dir_fd, path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return -1;
+    size_t total = 0;
+    while (total < size)
+    {
+        ssize_t nread = read(fd, buf + total, size - total);
+        if (nread < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            // ESRCH once the process exited
+            int error = errno;
+            close(fd);
+            errno = error;
+            return -1;
+        }
+        if (nread == 0)
+            break;
+        total += nread;
+    }
+    close(fd);
+    return total;
+}
+
+void forEachNumericEntry(int dir_fd, const std::function<void(int number, const char* name)>& callback)
+{
+    if (dir_fd == -1)
+        return;
+    // the same directory can be walked several times
+    lseek(dir_fd, 0, SEEK_SET);
+
+    NumericEntryStream entries(dir_fd);
+    int number;
+    const char* name;
+    while (entries.next(number, name))
+        callback(number, name);
+}
+
+NumericEntryStream::NumericEntryStream(int dir_fd)
+    : m_dir_fd(dir_fd), m_size(0), m_pos(0)
+{
+}
+
+bool NumericEntryStream::next(int& number, const char*& name)
+{
+    while (true)
+    {
+        if (m_pos >= m_size)
+        {
+            if (m_dir_fd == -1)
+                return false;
+            m_size = syscall(SYS_getdents64, m_dir_fd, m_buf, sizeof(m_buf));
+            m_pos = 0;
+            if (m_size <= 0)
+                return false;
+        }
+        struct linux_dirent64* entry = reinterpret_cast<struct linux_dirent64*>(m_buf + m_pos);
+        m_pos += entry->d_reclen;
+
+        // parse the number, skipping . and ..
+        name = entry->d_name;
+        if (*name < '0' || *name > '9')
+            continue;
+        number = 0;
+        for (const char* c = name; *c != '\0'; c++)
+            number = number * 10 + (*c - '0');
+        return true;
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef PROCFS_H
+#define PROCFS_H
+
+#include <functional>
+#include <string>
+
+#include <sys/types.h>
+
+// Low level helpers shared by the /proc readers
+
+// root of the proc filesystem, "/proc" by default, "/host/proc" for
+// instance to read the host from a container, or a synthetic tree
+// must be set before any reader is used
+void setProcRoot(const std::string& root);
+const std::string& procRoot();
+// procRoot() + "/" + relative
+std::string procPath(const std::string& relative);
+
+// same for the device nodes, "/dev" by default
+void setDevRoot(const std::string& root);
+const std::string& devRoot();
+
+// mount point of the cgroup v2 hierarchy, "/sys/fs/cgroup", or
+// "/sys/fs/cgroup/unified" on a hybrid system, detected on first use
+void setCgroupRoot(const std::string& root);
+const std::string& cgroupRoot();
+
+// read a whole file relative to dir_fd into buf with a single open/read/close
+// returns the number of bytes read, -1 if the file cannot be opened or read
+ssize_t readFileAt(int dir_fd, const char* path, char* buf, size_t size);
+
+// call callback for each entry of dir_fd named by a number (pid, tid, fd),
+// entries are pulled in large batches with getdents64
+void forEachNumericEntry(int dir_fd, const std::function<void(int number, const char* name)>& callback);
+
+// same entries pulled one at a time, from the current position of dir_fd
+class NumericEntryStream
+{
+public:
+    NumericEntryStream(int dir_fd);
+
+    // false at the end of the directory, name is valid until the next call
+    bool next(int& number, const char*& name);
+
+private:
+    int m_dir_fd;
+    char m_buf[32768];
+    long m_size;
+    long m_pos;
+};
+
+#endif // PROCFS_H
@@ -0,0 +1,58 @@
+#include <cstring>
+
+#include "procstat.h"
+
+bool parseStat(const char* buf, size_t len, struct proc_stat_t& stat)
+{
+    const char* end = buf + len;
+    const char* cur = buf;
+
+    // pid
+    stat.pid = 0;
+    while (cur < end && *cur >= '0' && *cur <= '9')
+        stat.pid = stat.pid * 10 + (*cur++ - '0');
+
+    // (comm)
+    const char* name_begin = static_cast<const char*>(memchr(cur, '(', end - cur));
+    if (name_begin == nullptr)
+        return false;
+    name_begin++;
+    const char* name_end = end;
+    while (name_end > name_begin && *(name_end - 1) != ')')
+        name_end--;
+    if (name_end == name_begin)
+        return false;
+    name_end--; // on the ')'
+    size_t name_len = name_end - name_begin;
+    if (name_len >= sizeof(stat.comm))
+        name_len = sizeof(stat.comm) - 1;
+    memcpy(stat.comm, name_begin, name_len);
+    stat.comm[name_len] = '\0';
+    cur = name_end + 1;
+
+    // state
+    while (cur < end && *cur == ' ')
+        cur++;
+    if (cur == end)
+        return false;
+    stat.state = *cur++;
+
+    // numeric fields
+    const size_t nb_fields = sizeof(stat.fields) / sizeof(stat.fields[0]);
+    for (size_t i = 0; i < nb_fields; i++)
+    {
+        while (cur < end && *cur == ' ')
+            cur++;
+        bool negative = false;
+        if (cur < end && *cur == '-')
+        {
+            negative = true;
+            cur++;
+        }
+        unsigned long long value = 0;
+        while (cur < end && *cur >= '0' && *cur <= '9')
+            value = value * 10 + (*cur++ - '0');
+        stat.fields[i] = negative ? -value : value;
+    }
+    return true;
+}
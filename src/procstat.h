@@ -0,0 +1,84 @@
+#ifndef PROCSTAT_H
+#define PROCSTAT_H
+
+#include <cstddef>
+
+#include <sys/types.h>
+
+// field numbers of /proc/<pid>/stat, as documented in proc(5)
+enum stat_field
+{
+    STAT_PPID = 4,
+    STAT_PGRP,
+    STAT_SESSION,
+    STAT_TTY_NR,
+    STAT_TPGID,
+    STAT_FLAGS,
+    STAT_MINFLT,
+    STAT_CMINFLT,
+    STAT_MAJFLT,
+    STAT_CMAJFLT,
+    STAT_UTIME,
+    STAT_STIME,
+    STAT_CUTIME,
+    STAT_CSTIME,
+    STAT_PRIORITY,
+    STAT_NICE,
+    STAT_NUM_THREADS,
+    STAT_ITREALVALUE,
+    STAT_STARTTIME,
+    STAT_VSIZE,
+    STAT_RSS,
+    STAT_RSSLIM,
+    STAT_STARTCODE,
+    STAT_ENDCODE,
+    STAT_STARTSTACK,
+    STAT_KSTKESP,
+    STAT_KSTKEIP,
+    STAT_SIGNAL,
+    STAT_BLOCKED,
+    STAT_SIGIGNORE,
+    STAT_SIGCATCH,
+    STAT_WCHAN,
+    STAT_NSWAP,
+    STAT_CNSWAP,
+    STAT_EXIT_SIGNAL,
+    STAT_PROCESSOR,
+    STAT_RT_PRIORITY,
+    STAT_POLICY,
+    STAT_DELAYACCT_BLKIO_TICKS,
+    STAT_GUEST_TIME,
+    STAT_CGUEST_TIME,
+    STAT_START_DATA,
+    STAT_END_DATA,
+    STAT_START_BRK,
+    STAT_ARG_START,
+    STAT_ARG_END,
+    STAT_ENV_START,
+    STAT_ENV_END,
+    STAT_EXIT_CODE,
+    STAT_LAST = STAT_EXIT_CODE
+};
+
+// parsed content of a stat file, without any allocation
+struct proc_stat_t
+{
+    pid_t pid;
+    // the kernel limits it to 64 bytes including the final '\0'
+    char comm[64];
+    char state;
+    // numeric fields from STAT_PPID, missing ones (older kernels) are 0,
+    // negative values are stored in two's complement
+    unsigned long long fields[STAT_LAST - STAT_PPID + 1];
+};
+
+// parse the content of /proc/<pid>/stat or /proc/<pid>/task/<tid>/stat
+// the name can contain spaces and parentheses, it ends at the last ')'
+bool parseStat(const char* buf, size_t len, struct proc_stat_t& stat);
+
+inline unsigned long long statField(const struct proc_stat_t& stat, enum stat_field field)
+{
+    return stat.fields[field - STAT_PPID];
+}
+
+#endif // PROCSTAT_H
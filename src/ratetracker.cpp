@@ -0,0 +1,143 @@
+#include <chrono>
+#include <utility>
+
+#include "ratetracker.h"
+
+RateTracker::RateTracker(unsigned int counters)
+    : m_counters(counters & COUNTER_ALL), m_time_groups(0)
+{
+    for (int c = 0; c < COUNTER_COUNT; c++)
+    {
+        if (m_counters & (1u << c))
+            m_time_groups |= 1u << timeGroup(static_cast<enum rate_counter>(c));
+    }
+}
+
+enum RateTracker::time_group RateTracker::timeGroup(enum rate_counter counter)
+{
+    switch (counterField(counter))
+    {
+    case FIELD_STATUS:
+        return TIME_STATUS;
+    case FIELD_IO:
+        return TIME_IO;
+    default:
+        return TIME_STAT;
+    }
+}
+
+unsigned int RateTracker::fields() const
+{
+    // stat for the start time
+    unsigned int fields = FIELD_STAT;
+    if (m_time_groups & (1u << TIME_STATUS))
+        fields |= FIELD_STATUS;
+    if (m_time_groups & (1u << TIME_IO))
+        fields |= FIELD_IO;
+    return fields;
+}
+
+void RateTracker::sample(std::vector<ProcessInfo>& snapshot)
+{
+    static const enum field_group time_fields[TIME_GROUP_COUNT] = { FIELD_STAT, FIELD_STATUS, FIELD_IO };
+    std::swap(m_previous, m_current);
+    struct sample_t& current = m_current;
+    const struct sample_t& previous = m_previous;
+    size_t count = snapshot.size();
+
+    // by column
+    current.pids.resize(count);
+    current.start_ticks.resize(count);
+    current.index.clear();
+    current.index.reserve(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        current.pids[i] = snapshot[i].pid();
+        current.start_ticks[i] = snapshot[i].startTicks();
+        current.index[current.pids[i]] = i;
+    }
+    for (int c = 0; c < COUNTER_COUNT; c++)
+    {
+        if (!(m_counters & (1u << c)))
+            continue;
+        current.values[c].resize(count);
+        for (size_t i = 0; i < count; i++)
+            current.values[c][i] = snapshot[i].counter(static_cast<enum rate_counter>(c));
+    }
+    // after the counters, which read their group if needed
+    for (int g = 0; g < TIME_GROUP_COUNT; g++)
+    {
+        if (!(m_time_groups & (1u << g)))
+            continue;
+        current.read_ns[g].resize(count);
+        for (size_t i = 0; i < count; i++)
+            current.read_ns[g][i] = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    snapshot[i].readTime(time_fields[g]).time_since_epoch()).count();
+    }
+
+    // match the processes once, -1 for the new ones
+    std::vector<long> matched(count, -1);
+    for (size_t i = 0; i < count; i++)
+    {
+        std::unordered_map<pid_t, size_t>::const_iterator it = previous.index.find(current.pids[i]);
+        if (it != previous.index.end() && previous.start_ticks[it->second] == current.start_ticks[i])
+            matched[i] = it->second;
+    }
+
+    // 1 / elapsed seconds per group, 0 without a previous sample
+    std::vector<double> inverse_elapsed[TIME_GROUP_COUNT];
+    for (int g = 0; g < TIME_GROUP_COUNT; g++)
+    {
+        if (!(m_time_groups & (1u << g)))
+            continue;
+        inverse_elapsed[g].assign(count, 0);
+        for (size_t i = 0; i < count; i++)
+        {
+            if (matched[i] == -1)
+                continue;
+            long long elapsed = current.read_ns[g][i] - previous.read_ns[g][matched[i]];
+            if (elapsed > 0)
+                inverse_elapsed[g][i] = 1e9 / elapsed;
+        }
+    }
+
+    // gather the previous values, then one flat loop per counter
+    std::vector<unsigned long long> before(count);
+    for (int c = 0; c < COUNTER_COUNT; c++)
+    {
+        m_rates[c].clear();
+        if (!(m_counters & (1u << c)))
+            continue;
+        const std::vector<unsigned long long>& after = current.values[c];
+        for (size_t i = 0; i < count; i++)
+            before[i] = matched[i] == -1 ? after[i] : previous.values[c][matched[i]];
+
+        const std::vector<double>& scale = inverse_elapsed[timeGroup(static_cast<enum rate_counter>(c))];
+        std::vector<double>& rates = m_rates[c];
+        rates.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            // a counter going back is treated as no progress
+            unsigned long long delta = after[i] >= before[i] ? after[i] - before[i] : 0;
+            rates[i] = delta * scale[i];
+        }
+    }
+}
+
+const std::vector<pid_t>& RateTracker::pids() const
+{
+    return m_current.pids;
+}
+
+const std::vector<double>& RateTracker::rates(enum rate_counter counter) const
+{
+    return m_rates[counter];
+}
+
+double RateTracker::rate(pid_t pid, enum rate_counter counter) const
+{
+    std::unordered_map<pid_t, size_t>::const_iterator it = m_current.index.find(pid);
+    if (it == m_current.index.end() || m_rates[counter].empty())
+        return 0;
+    return m_rates[counter][it->second];
+}
@@ -0,0 +1,68 @@
+#ifndef RATETRACKER_H
+#define RATETRACKER_H
+
+#include <unordered_map>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "processinfo.h"
+
+// Per second rates of the monotonic counters between two snapshots
+//
+// The counters of a snapshot are stored by column, one array per counter,
+// and each rate is the difference with the previous sample of the same
+// process divided by the CLOCK_MONOTONIC time between the two reads of
+// its file. The processes are matched once per sample, then every counter
+// is computed in a flat loop over the whole snapshot. A process seen for
+// the first time, or a pid reused since the previous sample, has a rate
+// of 0.
+class RateTracker
+{
+public:
+    // counters is a mask of 1 << rate_counter
+    explicit RateTracker(unsigned int counters = COUNTER_ALL);
+
+    // field_group to read in the snapshots given to sample()
+    unsigned int fields() const;
+
+    void sample(std::vector<ProcessInfo>& snapshot);
+
+    // processes of the last sample
+    const std::vector<pid_t>& pids() const;
+    // aligned with pids(), empty for a counter which is not tracked
+    const std::vector<double>& rates(enum rate_counter counter) const;
+    // 0 for an unknown process
+    double rate(pid_t pid, enum rate_counter counter) const;
+
+private:
+    // groups with a read time, the counters come from one of them
+    enum time_group
+    {
+        TIME_STAT,
+        TIME_STATUS,
+        TIME_IO,
+        TIME_GROUP_COUNT
+    };
+
+    struct sample_t
+    {
+        std::vector<pid_t> pids;
+        // to detect a reused pid
+        std::vector<unsigned long long> start_ticks;
+        // ns since the steady clock epoch
+        std::vector<long long> read_ns[TIME_GROUP_COUNT];
+        std::vector<unsigned long long> values[COUNTER_COUNT];
+        std::unordered_map<pid_t, size_t> index;
+    };
+
+    static enum time_group timeGroup(enum rate_counter counter);
+
+    unsigned int m_counters;
+    unsigned int m_time_groups;
+    struct sample_t m_previous;
+    struct sample_t m_current;
+    std::vector<double> m_rates[COUNTER_COUNT];
+};
+
+#endif // RATETRACKER_H
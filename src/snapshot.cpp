@@ -0,0 +1,325 @@
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include <boost/algorithm/string/join.hpp>
+
+#include "snapshot.h"
+#include "processinfo.h"
+
+namespace {
+
+struct file_header_t
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+};
+
+#define BLOCK_MAGIC 0x50414e53 // "SNAP"
+
+struct block_header_t
+{
+    uint32_t magic;
+    uint32_t count;
+    int64_t timestamp;
+    uint64_t strings_size;
+    // header, records and padded string table
+    uint64_t size;
+};
+
+size_t padding(size_t size)
+{
+    return (8 - size % 8) % 8;
+}
+
+// header and sizes consistent, available bytes from the block start
+bool validBlock(const struct block_header_t& block, uint64_t available)
+{
+    if (block.magic != BLOCK_MAGIC || block.size < sizeof(struct block_header_t) || block.size > available)
+        return false;
+    uint64_t payload = block.size - sizeof(struct block_header_t);
+    uint64_t records = static_cast<uint64_t>(block.count) * sizeof(struct process_record_t);
+    return records <= payload && block.strings_size <= payload - records;
+}
+
+bool validHeader(const struct file_header_t& header)
+{
+    return memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0
+            && header.version == SNAPSHOT_VERSION
+            && header.record_size == sizeof(struct process_record_t);
+}
+
+} // namespace
+
+StringTable::StringTable()
+{
+    clear();
+}
+
+uint32_t StringTable::add(boost::string_view str)
+{
+    if (str.empty())
+        return 0;
+    std::string key(str.data(), str.size());
+    std::unordered_map<std::string, uint32_t>::const_iterator it = m_offsets.find(key);
+    if (it != m_offsets.end())
+        return it->second;
+
+    uint32_t offset = m_data.size();
+    m_data.append(str.data(), str.size());
+    m_data.push_back('\0');
+    m_offsets.emplace(std::move(key), offset);
+    return offset;
+}
+
+void StringTable::clear()
+{
+    m_data.assign(1, '\0');
+    m_offsets.clear();
+}
+
+const std::string& StringTable::data() const
+{
+    return m_data;
+}
+
+void fillRecord(ProcessInfo& pinfo, struct process_record_t& record, StringTable& strings)
+{
+    memset(&record, 0, sizeof(record));
+    record.pid = pinfo.pid();
+    record.ppid = pinfo.ppid();
+    record.pgid = pinfo.pgid();
+    record.sid = pinfo.sid();
+    record.tty_nr = pinfo.ttyDevice();
+    record.processor = pinfo.processor();
+    record.flags = pinfo.flags();
+    record.priority = pinfo.priority();
+    record.nice = pinfo.nice();
+    record.num_threads = pinfo.numThreads();
+    record.utime = pinfo.utime();
+    record.stime = pinfo.stime();
+    record.cutime = pinfo.cutime();
+    record.cstime = pinfo.cstime();
+    record.minflt = pinfo.minflt();
+    record.majflt = pinfo.majflt();
+    record.starttime = pinfo.startTicks();
+    record.vm_size = pinfo.vmSize();
+    record.state = pinfo.state().empty() ? '?' : pinfo.state()[0];
+    record.cpu_usage = pinfo.cpuUsage();
+
+    record.vm_rss = pinfo.vmRss();
+    record.vm_swap = pinfo.vmSwap();
+    const std::vector<int>& uids = pinfo.uids();
+    if (!uids.empty())
+        record.uid = uids[0];
+    const std::vector<int>& gids = pinfo.gids();
+    if (!gids.empty())
+        record.gid = gids[0];
+
+    record.read_bytes = pinfo.readBytes();
+    record.write_bytes = pinfo.writeBytes();
+
+    record.name = strings.add(pinfo.name());
+    record.exe = strings.add(pinfo.exe());
+    record.cmdline = strings.add(boost::algorithm::join(pinfo.cmdline(), " "));
+}
+
+boost::string_view snapshot_view_t::string(uint32_t offset) const
+{
+    if (offset >= strings_size)
+        return boost::string_view();
+    return boost::string_view(strings + offset, strnlen(strings + offset, strings_size - offset));
+}
+
+struct snapshot_view_t makeSnapshotView(const std::vector<struct process_record_t>& records,
+                                        const StringTable& strings,
+                                        std::chrono::system_clock::time_point time)
+{
+    struct snapshot_view_t view;
+    view.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch());
+    view.records = records.data();
+    view.count = records.size();
+    view.strings = strings.data().data();
+    view.strings_size = strings.data().size();
+    return view;
+}
+
+SnapshotWriter::SnapshotWriter(const std::string& path)
+    : m_size(0)
+{
+    m_fd = open(path.c_str(), O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (m_fd == -1)
+        throw std::string(strerror(errno));
+    try
+    {
+        recover();
+    }
+    catch (...)
+    {
+        close(m_fd);
+        throw;
+    }
+}
+
+void SnapshotWriter::recover()
+{
+    struct stat st;
+    if (fstat(m_fd, &st) == -1)
+        throw std::string(strerror(errno));
+    uint64_t file_size = st.st_size;
+
+    struct file_header_t header;
+    if (file_size < sizeof(header))
+    {
+        // new file, or a crash while writing its header
+        if (file_size != 0 && ftruncate(m_fd, 0) == -1)
+            throw std::string(strerror(errno));
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        header.version = SNAPSHOT_VERSION;
+        header.record_size = sizeof(struct process_record_t);
+        if (::write(m_fd, &header, sizeof(header)) != sizeof(header))
+        {
+            int error = errno;
+            ftruncate(m_fd, 0);
+            throw std::string(error != 0 ? strerror(error) : "short write");
+        }
+        m_size = sizeof(header);
+        return;
+    }
+
+    if (pread(m_fd, &header, sizeof(header), 0) != sizeof(header) || !validHeader(header))
+        throw std::string("unsupported snapshot file");
+
+    // drop a torn last block, the next ones would be unreachable for readers
+    m_size = sizeof(header);
+    struct block_header_t block;
+    while (m_size + sizeof(block) <= file_size
+           && pread(m_fd, &block, sizeof(block), m_size) == sizeof(block)
+           && validBlock(block, file_size - m_size))
+        m_size += block.size;
+    if (m_size != file_size && ftruncate(m_fd, m_size) == -1)
+        throw std::string(strerror(errno));
+}
+
+SnapshotWriter::~SnapshotWriter()
+{
+    close(m_fd);
+}
+
+void SnapshotWriter::write(std::vector<ProcessInfo>& processes, std::chrono::system_clock::time_point time)
+{
+    m_records.resize(processes.size());
+    m_strings.clear();
+    for (size_t i = 0; i < processes.size(); i++)
+        fillRecord(processes[i], m_records[i], m_strings);
+    write(m_records, m_strings, time);
+}
+
+void SnapshotWriter::write(const std::vector<struct process_record_t>& records, const StringTable& strings,
+                           std::chrono::system_clock::time_point time)
+{
+    const std::string& table = strings.data();
+    static const char zeros[8] = {};
+
+    struct block_header_t header;
+    header.magic = BLOCK_MAGIC;
+    header.count = records.size();
+    header.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    header.strings_size = table.size();
+    header.size = sizeof(header) + records.size() * sizeof(struct process_record_t)
+            + table.size() + padding(table.size());
+
+    struct iovec iov[4];
+    iov[0].iov_base = &header;
+    iov[0].iov_len = sizeof(header);
+    iov[1].iov_base = const_cast<struct process_record_t*>(records.data());
+    iov[1].iov_len = records.size() * sizeof(struct process_record_t);
+    iov[2].iov_base = const_cast<char*>(table.data());
+    iov[2].iov_len = table.size();
+    iov[3].iov_base = const_cast<char*>(zeros);
+    iov[3].iov_len = padding(table.size());
+
+    ssize_t written = writev(m_fd, iov, 4);
+    if (written == -1 || static_cast<uint64_t>(written) != header.size)
+    {
+        std::string error = written == -1 ? strerror(errno) : "short write";
+        // remove the partial block so that the next ones stay readable
+        ftruncate(m_fd, m_size);
+        throw error;
+    }
+    m_size += written;
+}
+
+SnapshotReader::SnapshotReader(const std::string& path)
+    : m_data(nullptr), m_size(0)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        throw std::string(strerror(errno));
+    struct stat st;
+    if (fstat(fd, &st) == -1)
+    {
+        int error = errno;
+        close(fd);
+        throw std::string(strerror(error));
+    }
+    m_size = st.st_size;
+    if (m_size < sizeof(struct file_header_t))
+    {
+        close(fd);
+        throw std::string("not a snapshot file");
+    }
+    void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        throw std::string(strerror(errno));
+    m_data = static_cast<const char*>(data);
+
+    if (!validHeader(*reinterpret_cast<const struct file_header_t*>(m_data)))
+    {
+        munmap(const_cast<char*>(m_data), m_size);
+        throw std::string("unsupported snapshot file");
+    }
+
+    // only the block headers are read, a truncated last block is ignored
+    size_t offset = sizeof(struct file_header_t);
+    while (offset + sizeof(struct block_header_t) <= m_size)
+    {
+        const struct block_header_t* block = reinterpret_cast<const struct block_header_t*>(m_data + offset);
+        if (!validBlock(*block, m_size - offset))
+            break;
+        m_blocks.push_back(offset);
+        offset += block->size;
+    }
+}
+
+SnapshotReader::~SnapshotReader()
+{
+    munmap(const_cast<char*>(m_data), m_size);
+}
+
+size_t SnapshotReader::size() const
+{
+    return m_blocks.size();
+}
+
+struct snapshot_view_t SnapshotReader::at(size_t index) const
+{
+    const char* block_data = m_data + m_blocks.at(index);
+    const struct block_header_t* block = reinterpret_cast<const struct block_header_t*>(block_data);
+
+    struct snapshot_view_t view;
+    view.timestamp = std::chrono::nanoseconds(block->timestamp);
+    view.records = reinterpret_cast<const struct process_record_t*>(block_data + sizeof(struct block_header_t));
+    view.count = block->count;
+    view.strings = reinterpret_cast<const char*>(view.records + view.count);
+    view.strings_size = block->strings_size;
+    return view;
+}
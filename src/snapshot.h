@@ -0,0 +1,151 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+#include <boost/utility/string_view.hpp>
+
+class ProcessInfo;
+
+#define SNAPSHOT_MAGIC "SYSINFO"
+#define SNAPSHOT_VERSION 1
+// fields read by fillRecord()
+#define SNAPSHOT_FIELDS (FIELD_STAT | FIELD_STATUS | FIELD_IO | FIELD_CMDLINE | FIELD_EXE)
+
+// numeric fields of a process, fixed layout shared by the snapshot file and
+// the delta stream, strings are offsets in a string table
+struct process_record_t
+{
+    int32_t pid;
+    int32_t ppid;
+    int32_t pgid;
+    int32_t sid;
+    // device number, 0 without a controlling terminal
+    int32_t tty_nr;
+    int32_t processor;
+    uint32_t uid;
+    uint32_t gid;
+    uint32_t flags;
+    int32_t cpu_usage;
+    int64_t priority;
+    int64_t nice;
+    uint64_t num_threads;
+    uint64_t utime;
+    uint64_t stime;
+    uint64_t cutime;
+    uint64_t cstime;
+    uint64_t minflt;
+    uint64_t majflt;
+    // clock ticks after boot, constant for the process
+    uint64_t starttime;
+    uint64_t vm_size;
+    uint64_t vm_rss;
+    uint64_t vm_swap;
+    uint64_t read_bytes;
+    uint64_t write_bytes;
+    uint32_t name;
+    uint32_t exe;
+    // arguments separated by spaces
+    uint32_t cmdline;
+    // R, S, D, ...
+    char state;
+    char padding[3];
+};
+
+// '\0' terminated strings stored once, offset 0 is the empty string
+class StringTable
+{
+public:
+    StringTable();
+
+    uint32_t add(boost::string_view str);
+    void clear();
+    const std::string& data() const;
+
+private:
+    std::string m_data;
+    std::unordered_map<std::string, uint32_t> m_offsets;
+};
+
+// read SNAPSHOT_FIELDS of the process into record
+void fillRecord(ProcessInfo& pinfo, struct process_record_t& record, StringTable& strings);
+
+// one snapshot of a SnapshotReader, points into the mapped file
+struct snapshot_view_t
+{
+    // since epoch
+    std::chrono::nanoseconds timestamp;
+    const struct process_record_t* records;
+    size_t count;
+    const char* strings;
+    size_t strings_size;
+
+    // empty if offset is out of the table
+    boost::string_view string(uint32_t offset) const;
+};
+
+// view of records not coming from a file, valid while both are unchanged
+struct snapshot_view_t makeSnapshotView(const std::vector<struct process_record_t>& records,
+                                        const StringTable& strings,
+                                        std::chrono::system_clock::time_point time);
+
+// Appends process table snapshots to a file
+//
+// The file starts with a header (magic, version, record size) followed by
+// blocks, each one being a block header, the records and the string table
+// padded to 8 bytes. A snapshot is written with a single writev() on a
+// file opened in append mode. A failed write is truncated away, and a
+// block torn by a crash is removed when the file is opened again, so the
+// later snapshots are never appended after an unreadable block.
+class SnapshotWriter
+{
+public:
+    SnapshotWriter(const std::string& path);
+    ~SnapshotWriter();
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    void write(std::vector<ProcessInfo>& processes,
+               std::chrono::system_clock::time_point time = std::chrono::system_clock::now());
+    void write(const std::vector<struct process_record_t>& records, const StringTable& strings,
+               std::chrono::system_clock::time_point time);
+
+private:
+    // checks the header and truncates the file after its last complete block
+    void recover();
+
+    int m_fd;
+    // end of the last complete block
+    uint64_t m_size;
+    // reused between snapshots
+    std::vector<struct process_record_t> m_records;
+    StringTable m_strings;
+};
+
+// Maps a snapshot file and gives access to its snapshots without copying
+class SnapshotReader
+{
+public:
+    SnapshotReader(const std::string& path);
+    ~SnapshotReader();
+
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    size_t size() const;
+    struct snapshot_view_t at(size_t index) const;
+
+private:
+    const char* m_data;
+    size_t m_size;
+    // offset of each complete block
+    std::vector<size_t> m_blocks;
+};
+
+#endif // SNAPSHOT_H
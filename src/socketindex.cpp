@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <utility>
+
+#include "socketindex.h"
+#include "fdreader.h"
+#include "procfs.h"
+
+typedef std::vector<std::pair<unsigned long, struct socket_owner_t>> socket_entries_t;
+
+// collect the socket fds of a single process
+static void scanProcess(pid_t pid, socket_entries_t& entries)
+{
+    // process is gone or permission denied if not open
+    FdReader reader(procPath(std::to_string(pid) + "/fd"));
+    reader.forEach([pid, &entries](int fd, const char* target, size_t len) {
+        // socket:[12345]
+        static const char prefix[] = "socket:[";
+        static const size_t prefix_len = sizeof(prefix) - 1;
+        if (len <= prefix_len || strncmp(target, prefix, prefix_len) != 0)
+            return;
+
+        unsigned long inode = 0;
+        for (size_t i = prefix_len; i < len && target[i] >= '0' && target[i] <= '9'; i++)
+            inode = inode * 10 + (target[i] - '0');
+
+        struct socket_owner_t owner;
+        owner.pid = pid;
+        owner.fd = fd;
+        entries.push_back(std::make_pair(inode, owner));
+    });
+}
+
+SocketIndex::SocketIndex()
+{
+
+}
+
+void SocketIndex::build(unsigned int nb_threads)
+{
+    m_index.clear();
+
+    std::vector<int> pids = processListPid();
+    if (nb_threads == 0)
+        nb_threads = std::max(1u, std::thread::hardware_concurrency());
+    nb_threads = std::min<unsigned int>(nb_threads, std::max<size_t>(1, pids.size()));
+
+    // workers pull pids from a shared cursor, so one process with a huge
+    // fd table does not hold back a whole static partition
+    std::atomic<size_t> next(0);
+    std::vector<socket_entries_t> results(nb_threads);
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < nb_threads; i++)
+    {
+        workers.push_back(std::thread([&pids, &next, &results, i]() {
+            size_t cur;
+            while ((cur = next++) < pids.size())
+                scanProcess(pids[cur], results[i]);
+        }));
+    }
+    for (std::thread& worker : workers)
+        worker.join();
+
+    // merge
+    for (const socket_entries_t& entries : results)
+        for (const std::pair<unsigned long, struct socket_owner_t>& entry : entries)
+            m_index[entry.first].push_back(entry.second);
+}
+
+void SocketIndex::clear()
+{
+    m_index.clear();
+}
+
+const std::vector<struct socket_owner_t>& SocketIndex::owners(unsigned long inode) const
+{
+    static const std::vector<struct socket_owner_t> no_owner;
+    std::unordered_map<unsigned long, std::vector<struct socket_owner_t>>::const_iterator it = m_index.find(inode);
+    if (it == m_index.end())
+        return no_owner;
+    return it->second;
+}
+
+void SocketIndex::attach(std::vector<struct tcp_socket_t>& sockets) const
+{
+    for (struct tcp_socket_t& socket : sockets)
+        socket.owners = owners(socket.inode);
+}
+
+void SocketIndex::attach(std::vector<struct unix_socket_t>& sockets) const
+{
+    for (struct unix_socket_t& socket : sockets)
+        socket.owners = owners(socket.inode);
+}
+
+size_t SocketIndex::size() const
+{
+    return m_index.size();
+}
@@ -0,0 +1,37 @@
+#ifndef SOCKETINDEX_H
+#define SOCKETINDEX_H
+
+#include <unordered_map>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "sysinfo.h"
+
+// Maps socket inodes to the processes holding them
+//
+// build() walks every /proc/<pid>/fd directory once, spread over several
+// threads, and keeps an inode -> (pid, fd) index. The sockets returned by
+// getSocketTCP() / getSocketUNIX() can then be attributed with attach()
+// without scanning /proc again for each query.
+class SocketIndex
+{
+public:
+    SocketIndex();
+
+    // nb_threads == 0 uses the number of hardware threads
+    void build(unsigned int nb_threads = 0);
+    void clear();
+
+    const std::vector<struct socket_owner_t>& owners(unsigned long inode) const;
+    void attach(std::vector<struct tcp_socket_t>& sockets) const;
+    void attach(std::vector<struct unix_socket_t>& sockets) const;
+
+    // number of distinct socket inodes
+    size_t size() const;
+
+private:
+    std::unordered_map<unsigned long, std::vector<struct socket_owner_t>> m_index;
+};
+
+#endif // SOCKETINDEX_H
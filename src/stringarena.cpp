@@ -0,0 +1,78 @@
+#include <cstring>
+
+#include "stringarena.h"
+
+// strings longer than this get a block of their own
+static const size_t block_size = 64 * 1024;
+
+StringArena::StringArena()
+    : m_block_used(block_size), m_bytes(0)
+{
+    m_strings.push_back(boost::string_view());
+}
+
+StringArena::handle_t StringArena::intern(boost::string_view str)
+{
+    if (str.empty())
+        return empty;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unordered_map<boost::string_view, handle_t, boost::hash<boost::string_view>>::const_iterator it = m_index.find(str);
+    if (it != m_index.end())
+        return it->second;
+
+    boost::string_view stored(store(str), str.size());
+    handle_t handle = static_cast<handle_t>(m_strings.size());
+    m_strings.push_back(stored);
+    m_index[stored] = handle;
+    return handle;
+}
+
+boost::string_view StringArena::view(handle_t handle) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (handle >= m_strings.size())
+        return boost::string_view();
+    return m_strings[handle];
+}
+
+size_t StringArena::count() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_strings.size() - 1;
+}
+
+size_t StringArena::bytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bytes;
+}
+
+const char* StringArena::store(boost::string_view str)
+{
+    // keep a trailing '\0' so the views can be handed to C APIs
+    size_t needed = str.size() + 1;
+    if (needed > block_size)
+    {
+        m_blocks.push_back(std::unique_ptr<char[]>(new char[needed]));
+        m_bytes += needed;
+        char* dest = m_blocks.back().get();
+        // keep filling the current block
+        if (m_blocks.size() > 1)
+            std::swap(m_blocks.back(), m_blocks[m_blocks.size() - 2]);
+        memcpy(dest, str.data(), str.size());
+        dest[str.size()] = '\0';
+        return dest;
+    }
+    if (m_block_used + needed > block_size)
+    {
+        m_blocks.push_back(std::unique_ptr<char[]>(new char[block_size]));
+        m_bytes += block_size;
+        m_block_used = 0;
+    }
+    char* dest = m_blocks.back().get() + m_block_used;
+    memcpy(dest, str.data(), str.size());
+    dest[str.size()] = '\0';
+    m_block_used += needed;
+    return dest;
+}
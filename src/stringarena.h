@@ -0,0 +1,52 @@
+#ifndef STRINGARENA_H
+#define STRINGARENA_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+#include <boost/utility/string_view.hpp>
+
+// Stores each distinct string once and hands out 32 bits handles
+//
+// Strings are copied into large blocks which are never moved nor freed
+// before the arena itself, so the views returned by view() stay valid as
+// long as the arena lives. A snapshot shares one arena between all its
+// ProcessInfo, so the path of a library mapped by thousands of processes
+// is only stored once.
+class StringArena
+{
+public:
+    typedef uint32_t handle_t;
+    // always refers to the empty string
+    static const handle_t empty = 0;
+
+    StringArena();
+
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+
+    handle_t intern(boost::string_view str);
+    boost::string_view view(handle_t handle) const;
+
+    // number of distinct strings
+    size_t count() const;
+    // bytes allocated for the string data
+    size_t bytes() const;
+
+private:
+    const char* store(boost::string_view str);
+
+    mutable std::mutex m_mutex;
+    std::vector<std::unique_ptr<char[]>> m_blocks;
+    size_t m_block_used;
+    size_t m_bytes;
+    std::vector<boost::string_view> m_strings;
+    std::unordered_map<boost::string_view, handle_t, boost::hash<boost::string_view>> m_index;
+};
+
+#endif // STRINGARENA_H
@@ -4,19 +4,23 @@
 #include <chrono>
 #include <sys/sysinfo.h>
 #include <boost/regex.hpp>
-#include <boost/filesystem.hpp>
 #include <boost/algorithm/string.hpp>
 
 #include "sysinfo.h"
+#include "procfs.h"
+#include "procbackend.h"
+#include "instrumentation.h"
+#include "batchreader.h"
 
 // Public API
 
 // System info
 std::vector<cpu_info_t> readCPUInfo()
 {
+    SourceProbe probe(SOURCE_CPUINFO);
     std::vector<cpu_info_t> cpuinfo = std::vector<cpu_info_t>();
     // open /proc/cpuinfo
-    std::ifstream if_cpuinfo("/proc/cpuinfo");
+    ProcStream if_cpuinfo(procPath("cpuinfo"));
 
     // read until end
     std::string cur_line;
@@ -135,18 +139,14 @@ int getNbCores()
 std::vector<int> processListPid()
 {
     std::vector<int> process_pid_list;
-    boost::filesystem::path proc_path("/proc");
-    boost::filesystem::directory_iterator end_itr;
-    for (boost::filesystem::directory_iterator itr(proc_path);
-         itr != end_itr;
-         ++itr)
+    std::vector<std::string> names;
+    procBackend().listDir(procRoot(), names);
+    for (const std::string& name : names)
     {
-        if (boost::filesystem::is_directory(itr->status())
-                && boost::regex_match(itr->path().filename().string(), boost::regex("\\d+")))
-        {
-            int pid = std::stoi(itr->path().filename().string());
-            process_pid_list.push_back(pid);
-        }
+        // only the process directories are named by a number
+        if (name.empty() || name.find_first_not_of("0123456789") != std::string::npos)
+            continue;
+        process_pid_list.push_back(std::stoi(name));
     }
     return process_pid_list;
 }
@@ -156,25 +156,78 @@ int processCount()
     return processListPid().size();
 }
 
-std::vector<ProcessInfo> processList()
+std::vector<ProcessInfo> processList(unsigned int fields)
 {
+    std::vector<ProcessInfo> process_list;
+    // one arena for the whole snapshot
+    std::shared_ptr<StringArena> arena = std::make_shared<StringArena>();
+    ProcessRange range(fields, arena);
+    // growing the vector would move every ProcessInfo at each reallocation
+    process_list.reserve(range.sizeHint());
+    for (ProcessInfo& pinfo : range)
+    {
+        // moved into the list, never copied
+        process_list.push_back(std::move(pinfo));
+    }
+    return process_list;
+}
+
+std::vector<ProcessInfo> processListBatched(unsigned int fields)
+{
+    // recordings and replays go through the backend, file by file
+    if (!procBackend().isLive())
+        return processList(fields);
+
+    // the groups read from a single small file
+    static const std::pair<unsigned int, const char*> batched_files[] = {
+        { FIELD_STAT, "stat" },     { FIELD_STATUS, "status" }, { FIELD_IO, "io" },
+        { FIELD_CMDLINE, "cmdline" }, { FIELD_ENVIRON, "environ" }, { FIELD_WCHAN, "wchan" },
+        { FIELD_CGROUP, "cgroup" }, { FIELD_LIMITS, "limits" },  { FIELD_STACK, "stack" }
+    };
+    std::vector<const char*> files;
+    for (const std::pair<unsigned int, const char*>& it : batched_files)
+    {
+        if (fields & it.first)
+            files.push_back(it.second);
+    }
+
     std::vector<ProcessInfo> process_list;
     std::vector<int> process_pid_list = processListPid();
+    std::shared_ptr<StringArena> arena = std::make_shared<StringArena>();
+    process_list.reserve(process_pid_list.size());
 
-    for (int pid : process_pid_list)
+    BatchReader reader;
+    std::vector<struct batch_read_t> reads;
+    // the processes of a batch are parsed before the next one is read
+    const size_t batch_processes = 128;
+    for (size_t begin = 0; begin < process_pid_list.size(); begin += batch_processes)
     {
-        try {
-            ProcessInfo pinfo(pid);
-            process_list.push_back(pinfo);
-        } catch (std::string e)
+        size_t end = std::min(begin + batch_processes, process_pid_list.size());
+        reads.resize((end - begin) * files.size());
+        std::vector<struct batch_read_t>::iterator read = reads.begin();
+        for (size_t i = begin; i < end; i++)
         {
-            continue;
+            // same paths as ProcessInfo
+            std::string proc_path = procPath(std::to_string(process_pid_list[i])) + "/";
+            for (const char* file : files)
+                (read++)->path = proc_path + file;
         }
-        catch (std::ios_base::failure e) // the process died while we tried to read a file
+        reader.read(reads);
+
+        BatchScope scope(reads);
+        for (size_t i = begin; i < end; i++)
         {
-            continue;
+            try {
+                process_list.emplace_back(process_pid_list[i], fields, arena);
+            } catch (const std::string& e)
+            {
+                continue;
+            }
+            catch (const std::ios_base::failure& e)
+            {
+                continue;
+            }
         }
-
     }
     return process_list;
 }
@@ -182,19 +235,20 @@ std::vector<ProcessInfo> processList()
 // Network
 std::vector<struct unix_socket_t> getSocketUNIX()
 {
+    SourceProbe probe(SOURCE_NET_UNIX);
     std::vector<struct unix_socket_t> unix_socket_list;
-    std::ifstream if_unix("/proc/net/unix");
+    ProcStream if_unix(procPath("net/unix"));
     if (if_unix.is_open())
     {
         // skip first line
         // Num       RefCount Protocol Flags    Type St Inode Path
         std::string line;
+        // line sample (the path is optional)
+        // ffff8800c6110000: 00000002 00000000 00010000 0001 01 29692 @/tmp/.ICE-unix/3006
+        boost::regex regex("^([[:xdigit:]]+):\\s+([[:xdigit:]]+)\\s+([[:xdigit:]]+)\\s+([[:xdigit:]]+)\\s+([[:xdigit:]]+)\\s+([[:xdigit:]]+)\\s+([[:digit:]]+)\\s*(.*)$");
+        boost::smatch match;
         while (getline(if_unix, line))
         {
-            // line sample
-            // ffff8800c6110000: 00000002 00000000 00010000 0001 01 29692 @/tmp/.ICE-unix/3006
-            boost::regex regex("^([[:xdigit:]]+):\\s([[:digit:]]+)\\s([[:digit:]]+)\\s([[:digit:]]+)\\s([[:digit:]]+)\\s([[:digit:]]+)\\s([[:digit:]]+)\\s(.*)$");
-            boost::smatch match;
             if (boost::regex_match(line, match, regex))
             {
                 struct unix_socket_t socket;
@@ -202,11 +256,11 @@ std::vector<struct unix_socket_t> getSocketUNIX()
                 {
                     socket.num = match[1]; // TODO xdigit
                     socket.ref_count = std::stoi(match[2], 0, 16);
-                    socket.protocol = std::stoi(match[3]);
-                    socket.flags = std::stoi(match[4]);
-                    socket.type = std::stoi(match[5]);
-                    socket.state = static_cast<enum socket_state>(std::stoi(match[6]));
-                    socket.inode = std::stoi(match[7]);
+                    socket.protocol = std::stoi(match[3], 0, 16);
+                    socket.flags = std::stoi(match[4], 0, 16);
+                    socket.type = std::stoi(match[5], 0, 16);
+                    socket.state = static_cast<enum socket_state>(std::stoi(match[6], 0, 16));
+                    socket.inode = std::stoul(match[7]);
                     socket.path = match[8];
                     unix_socket_list.push_back(socket);
                 }
@@ -220,35 +274,48 @@ std::vector<struct unix_socket_t> getSocketUNIX()
 
 std::vector<struct tcp_socket_t> getSocketTCP()
 {
+    SourceProbe probe(SOURCE_NET_TCP);
     std::vector<struct tcp_socket_t> tcp_socket_list;
-    std::ifstream if_tcp("/proc/net/tcp");
+    ProcStream if_tcp(procPath("net/tcp"));
     if (if_tcp.is_open())
     {
         // skip first line
         //   sl  local_address rem_address   st tx_queue rx_queue tr tm->when retrnsmt   uid  timeout inode
         std::string line;
+        // line sample
+        //   0: 0ABCDEF:0035 00000000:0000 0A 00000000:00000000 00:00000000 00000000     0        0 29706 1 ffff8800c63f8000 100 0 0 10 0
+        boost::regex regex("^\\s*([[:digit:]]+):\\s([[:xdigit:]]+):([[:xdigit:]]+)\\s([[:xdigit:]]+):([[:xdigit:]]+)"
+                           "\\s([[:xdigit:]]+)\\s([[:xdigit:]]+):([[:xdigit:]]+)\\s([[:xdigit:]]+):([[:xdigit:]]+)"
+                           "\\s([[:xdigit:]]+)\\s+([[:digit:]]+)\\s+([[:digit:]]+)\\s+([[:digit:]]+).*$");
+        boost::smatch match;
         while (getline(if_tcp, line))
         {
-            // line sample
-            //   0: 0ABCDEF:0035 00000000:0000 0A 00000000:00000000 00:00000000 00000000     0        0 29706 1 ffff8800c63f8000 100 0 0 10 0
-            boost::regex regex("^\\s+([[:digit:]]+):\\s([[:xdigit:]]+):([[:xdigit:]]+)\\s([[:xdigit:]]+):([[:xdigit:]]+).*$");
-            boost::smatch match;
             if (boost::regex_match(line, match, regex))
             {
                 struct tcp_socket_t socket;
-                if (match.size() == 5 + 1) // first match represents whole line
+                if (match.size() == 14 + 1) // first match represents whole line
                 {
                     struct in_addr addr;
 
                     socket.num = std::stoi(match[1]);
-                    addr.s_addr = htonl(std::stol(match[2], 0, 16));
+                    addr.s_addr = std::stoul(match[2], 0, 16); // already in network byte order
                     socket.local_address = std::string(inet_ntoa(addr));
                     socket.local_port = std::stoi(match[3], 0, 16);
 
-                    addr.s_addr = htonl(std::stol(match[4], 0, 16));
+                    addr.s_addr = std::stoul(match[4], 0, 16); // already in network byte order
                     socket.rem_address = std::string(inet_ntoa(addr));
                     socket.rem_port = std::stoi(match[5], 0, 16);
 
+                    socket.state = std::stoi(match[6], 0, 16);
+                    socket.tx_queue = static_cast<int>(std::stoul(match[7], 0, 16));
+                    socket.rx_queue = static_cast<int>(std::stoul(match[8], 0, 16));
+                    socket.timer_active = std::stoi(match[9], 0, 16);
+                    socket.tm_when = static_cast<int>(std::stoul(match[10], 0, 16));
+                    socket.retrnsmt = static_cast<int>(std::stoul(match[11], 0, 16));
+                    socket.uid = std::stoi(match[12]);
+                    // match[13] is the timeout
+                    socket.inode = std::stoul(match[14]);
+
                     tcp_socket_list.push_back(socket);
                 }
             }
@@ -15,6 +15,12 @@
 
 #include "procconnector.h"
 #include "processinfo.h"
+#include "processrange.h"
+#include "topk.h"
+#include "processtree.h"
+#include "cgroupreader.h"
+#include "pressure.h"
+#include "ratetracker.h"
 
 // fwd
 class ProcessInfo;
@@ -58,7 +64,12 @@ int getNbCores();
 
 std::vector<int> processListPid();
 int processCount();
-std::vector<ProcessInfo> processList();
+// fields is a mask of field_group read during the scan
+// every process at once, see ProcessRange to stream them
+std::vector<ProcessInfo> processList(unsigned int fields = FIELD_NONE);
+// same result, the small per process files of fields are read in batches
+// through io_uring (see BatchReader), a few syscalls for hundreds of files
+std::vector<ProcessInfo> processListBatched(unsigned int fields = FIELD_NONE);
 // network
 
 enum socket_state {
@@ -78,6 +89,13 @@ enum socket_state {
     TCP_MAX_STATES	/* Leave at the end! */
 };
 
+// process holding a socket, filled by SocketIndex::attach()
+struct socket_owner_t
+{
+    pid_t pid;
+    int fd;
+};
+
 struct unix_socket_t
 {
     std::string num;
@@ -86,8 +104,9 @@ struct unix_socket_t
     int flags;
     int type;
     enum socket_state state;
-    int inode;
+    unsigned long inode;
     std::string path;
+    std::vector<struct socket_owner_t> owners;
 };
 
 struct tcp_socket_t
@@ -104,6 +123,8 @@ struct tcp_socket_t
     int tm_when;
     int retrnsmt;
     int uid;
+    unsigned long inode;
+    std::vector<struct socket_owner_t> owners;
 };
 
 std::vector<struct unix_socket_t> getSocketUNIX();
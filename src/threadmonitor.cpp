@@ -0,0 +1,108 @@
+#include <cstdio>
+#include <functional>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "threadmonitor.h"
+#include "procfs.h"
+#include "procbackend.h"
+#include "procstat.h"
+
+ThreadMonitor::ThreadMonitor(pid_t pid)
+    : m_pid(pid), m_task_fd(-1), m_live(procBackend().isLive())
+{
+    m_task_path = procPath(std::to_string(pid) + "/task");
+    if (m_live)
+        m_task_fd = open(m_task_path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    m_hz = sysconf(_SC_CLK_TCK);
+}
+
+ThreadMonitor::~ThreadMonitor()
+{
+    if (m_task_fd != -1)
+        close(m_task_fd);
+}
+
+bool ThreadMonitor::sample()
+{
+    if (m_live && m_task_fd == -1)
+        return false;
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = now - m_last_sample;
+    bool first = m_previous.empty();
+
+    std::unordered_map<pid_t, long unsigned int> current;
+    current.reserve(m_previous.size());
+    m_threads.clear();
+
+    int task_fd = m_task_fd;
+    std::function<void(int, const char*)> visit = [&](int tid, const char* name) {
+        // <tid>/stat
+        char buf[2048];
+        ssize_t len;
+        if (m_live)
+        {
+            char path[32];
+            snprintf(path, sizeof(path), "%s/stat", name);
+            len = readFileAt(task_fd, path, buf, sizeof(buf));
+        }
+        else
+        {
+            len = procBackend().readFile(m_task_path + "/" + name + "/stat", buf, sizeof(buf));
+        }
+        struct proc_stat_t stat;
+        if (len <= 0 || !parseStat(buf, len, stat))
+            return; // thread exited
+
+        struct thread_info_t thread;
+        thread.tid = tid;
+        thread.name = stat.comm;
+        thread.state = stat.state;
+        thread.utime = statField(stat, STAT_UTIME);
+        thread.stime = statField(stat, STAT_STIME);
+        thread.processor = statField(stat, STAT_PROCESSOR);
+        thread.starttime = statField(stat, STAT_STARTTIME);
+        thread.cpu_usage = 0;
+
+        long unsigned int total = thread.utime + thread.stime;
+        if (!first && elapsed.count() > 0)
+        {
+            std::unordered_map<pid_t, long unsigned int>::const_iterator it = m_previous.find(tid);
+            // new threads are measured from the next sample
+            if (it != m_previous.end() && total >= it->second)
+                thread.cpu_usage = 100.0 * (total - it->second) / m_hz / elapsed.count();
+        }
+        current[tid] = total;
+        m_threads.push_back(thread);
+    };
+
+    if (m_live)
+    {
+        forEachNumericEntry(task_fd, visit);
+    }
+    else
+    {
+        std::vector<std::string> names;
+        procBackend().listDir(m_task_path, names);
+        for (const std::string& name : names)
+            if (!name.empty() && name.find_first_not_of("0123456789") == std::string::npos)
+                visit(std::stoi(name), name.c_str());
+    }
+
+    m_previous.swap(current);
+    m_last_sample = now;
+    // the task directory of a dead process is empty
+    return !m_threads.empty();
+}
+
+const std::vector<struct thread_info_t>& ThreadMonitor::threads() const
+{
+    return m_threads;
+}
+
+pid_t ThreadMonitor::pid() const
+{
+    return m_pid;
+}
@@ -0,0 +1,57 @@
+#ifndef THREADMONITOR_H
+#define THREADMONITOR_H
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/types.h>
+
+struct thread_info_t
+{
+    pid_t tid;
+    std::string name;
+    // R, S, D, ...
+    char state;
+    long unsigned int utime;
+    long unsigned int stime;
+    int processor;
+    long long unsigned int starttime;
+    // percentage of one cpu since the previous sample, 0 on the first one
+    double cpu_usage;
+};
+
+// Samples the threads of a process from /proc/<pid>/task
+//
+// The task directory stays open between samples and each thread stat is
+// read with a single openat/read/close and parsed without allocation, so
+// sampling processes with thousands of threads at 1 Hz stays cheap.
+class ThreadMonitor
+{
+public:
+    ThreadMonitor(pid_t pid);
+    ~ThreadMonitor();
+
+    ThreadMonitor(const ThreadMonitor&) = delete;
+    ThreadMonitor& operator=(const ThreadMonitor&) = delete;
+
+    // false if the process is gone
+    bool sample();
+    const std::vector<struct thread_info_t>& threads() const;
+    pid_t pid() const;
+
+private:
+    pid_t m_pid;
+    std::string m_task_path;
+    int m_task_fd;
+    // false to read through procBackend()
+    bool m_live;
+    long m_hz;
+    std::vector<struct thread_info_t> m_threads;
+    // tid -> utime + stime at the previous sample
+    std::unordered_map<pid_t, long unsigned int> m_previous;
+    std::chrono::steady_clock::time_point m_last_sample;
+};
+
+#endif // THREADMONITOR_H
@@ -0,0 +1,188 @@
+#include "timeseries.h"
+
+namespace {
+
+// payload size selected by a prefix of 0, 1, 2, 3 or 4 bits set to 1,
+// the zero bucket has no payload and the last one has no final 0
+const int TIMESTAMP_BITS[] = {0, 7, 9, 12, 64};
+const int VALUE_BITS[] = {0, 8, 16, 32, 64};
+const int NB_BUCKETS = 5;
+
+uint64_t zigzag(int64_t value)
+{
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value)
+{
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+int bucket(uint64_t value, const int* bits)
+{
+    if (value == 0)
+        return 0;
+    for (int i = 1; i < NB_BUCKETS - 1; i++)
+        if (value < (1ULL << bits[i]))
+            return i;
+    return NB_BUCKETS - 1;
+}
+
+} // namespace
+
+TimeSeriesEncoder::TimeSeriesEncoder()
+    : m_bits(0), m_count(0), m_last_timestamp(0), m_last_delta(0), m_last_value(0)
+{
+}
+
+void TimeSeriesEncoder::append(int64_t timestamp, uint64_t value)
+{
+    if (m_count == 0)
+    {
+        writeBits(timestamp, 64);
+        writeBits(value, 64);
+    }
+    else
+    {
+        int64_t delta = timestamp - m_last_timestamp;
+        uint64_t dod = zigzag(delta - m_last_delta);
+        int i = bucket(dod, TIMESTAMP_BITS);
+        // prefix: i bits set to 1, then a 0 except for the last bucket
+        writeBits((1ULL << i) - 1, i);
+        if (i < NB_BUCKETS - 1)
+            writeBits(0, 1);
+        writeBits(dod, TIMESTAMP_BITS[i]);
+        m_last_delta = delta;
+
+        uint64_t diff = zigzag(static_cast<int64_t>(value - m_last_value));
+        i = bucket(diff, VALUE_BITS);
+        writeBits((1ULL << i) - 1, i);
+        if (i < NB_BUCKETS - 1)
+            writeBits(0, 1);
+        writeBits(diff, VALUE_BITS[i]);
+    }
+    m_last_timestamp = timestamp;
+    m_last_value = value;
+    m_count++;
+}
+
+void TimeSeriesEncoder::clear()
+{
+    m_data.clear();
+    m_bits = 0;
+    m_count = 0;
+    m_last_timestamp = 0;
+    m_last_delta = 0;
+    m_last_value = 0;
+}
+
+const std::vector<uint8_t>& TimeSeriesEncoder::data() const
+{
+    return m_data;
+}
+
+size_t TimeSeriesEncoder::count() const
+{
+    return m_count;
+}
+
+size_t TimeSeriesEncoder::bits() const
+{
+    return m_bits;
+}
+
+void TimeSeriesEncoder::writeBits(uint64_t value, int nb_bits)
+{
+    // most significant bit first, filling the last byte before adding one
+    while (nb_bits > 0)
+    {
+        int used = m_bits % 8;
+        if (used == 0)
+            m_data.push_back(0);
+        int room = 8 - used;
+        int chunk = nb_bits < room ? nb_bits : room;
+        uint8_t bits = (value >> (nb_bits - chunk)) & ((1U << chunk) - 1);
+        m_data.back() |= bits << (room - chunk);
+        nb_bits -= chunk;
+        m_bits += chunk;
+    }
+}
+
+TimeSeriesDecoder::TimeSeriesDecoder(const uint8_t* data, size_t size, size_t count)
+    : m_data(data), m_size(size), m_remaining(count), m_bit(0), m_first(true),
+      m_last_timestamp(0), m_last_delta(0), m_last_value(0)
+{
+}
+
+TimeSeriesDecoder::TimeSeriesDecoder(const TimeSeriesEncoder& encoder)
+    : TimeSeriesDecoder(encoder.data().data(), encoder.data().size(), encoder.count())
+{
+}
+
+bool TimeSeriesDecoder::next(int64_t& timestamp, uint64_t& value)
+{
+    if (m_remaining == 0)
+        return false;
+
+    if (m_first)
+    {
+        uint64_t raw_timestamp;
+        if (!readBits(64, raw_timestamp) || !readBits(64, m_last_value))
+            return false;
+        m_last_timestamp = raw_timestamp;
+        m_first = false;
+    }
+    else
+    {
+        int i = readPrefix(NB_BUCKETS - 1);
+        uint64_t dod;
+        if (i < 0 || !readBits(TIMESTAMP_BITS[i], dod))
+            return false;
+        m_last_delta += unzigzag(dod);
+        m_last_timestamp += m_last_delta;
+
+        i = readPrefix(NB_BUCKETS - 1);
+        uint64_t diff;
+        if (i < 0 || !readBits(VALUE_BITS[i], diff))
+            return false;
+        m_last_value += unzigzag(diff);
+    }
+
+    timestamp = m_last_timestamp;
+    value = m_last_value;
+    m_remaining--;
+    return true;
+}
+
+bool TimeSeriesDecoder::readBits(int nb_bits, uint64_t& value)
+{
+    if (m_bit + nb_bits > m_size * 8)
+        return false;
+    value = 0;
+    while (nb_bits > 0)
+    {
+        int used = m_bit % 8;
+        int room = 8 - used;
+        int chunk = nb_bits < room ? nb_bits : room;
+        uint8_t bits = (m_data[m_bit / 8] >> (room - chunk)) & ((1U << chunk) - 1);
+        value = (value << chunk) | bits;
+        nb_bits -= chunk;
+        m_bit += chunk;
+    }
+    return true;
+}
+
+int TimeSeriesDecoder::readPrefix(int max)
+{
+    int ones = 0;
+    while (ones < max)
+    {
+        uint64_t bit;
+        if (!readBits(1, bit))
+            return -1;
+        if (bit == 0)
+            break;
+        ones++;
+    }
+    return ones;
+}
@@ -0,0 +1,69 @@
+#ifndef TIMESERIES_H
+#define TIMESERIES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Compressed block of (timestamp, integer value) samples
+//
+// The encoding follows the Gorilla paper: the first sample is stored raw,
+// then each timestamp is stored as the difference between its delta and
+// the previous delta, and each value as the zig-zag encoded difference
+// with the previous value. Both use a short prefix selecting the number of
+// bits, so a regular 1 Hz sampling of a flat or steadily growing counter
+// costs a few bits per sample.
+//
+// All the values read by ProcessInfo are integers, floating point values
+// have to be scaled by the caller.
+class TimeSeriesEncoder
+{
+public:
+    TimeSeriesEncoder();
+
+    // timestamps are expected in increasing order, in any unit (ms, s, ...)
+    void append(int64_t timestamp, uint64_t value);
+    void clear();
+
+    const std::vector<uint8_t>& data() const;
+    size_t count() const;
+    // number of meaningful bits in data()
+    size_t bits() const;
+
+private:
+    void writeBits(uint64_t value, int nb_bits);
+
+    std::vector<uint8_t> m_data;
+    size_t m_bits;
+    size_t m_count;
+    int64_t m_last_timestamp;
+    int64_t m_last_delta;
+    uint64_t m_last_value;
+};
+
+// Streaming decoder of a TimeSeriesEncoder block
+class TimeSeriesDecoder
+{
+public:
+    TimeSeriesDecoder(const uint8_t* data, size_t size, size_t count);
+    explicit TimeSeriesDecoder(const TimeSeriesEncoder& encoder);
+
+    // false once count samples have been read or the block is truncated
+    bool next(int64_t& timestamp, uint64_t& value);
+
+private:
+    bool readBits(int nb_bits, uint64_t& value);
+    // number of 1 before the first 0, up to max
+    int readPrefix(int max);
+
+    const uint8_t* m_data;
+    size_t m_size;
+    size_t m_remaining;
+    size_t m_bit;
+    bool m_first;
+    int64_t m_last_timestamp;
+    int64_t m_last_delta;
+    uint64_t m_last_value;
+};
+
+#endif // TIMESERIES_H
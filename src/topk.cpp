@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <utility>
+
+#include "topk.h"
+#include "processrange.h"
+
+namespace {
+
+struct ranked_t
+{
+    double value;
+    ProcessInfo pinfo;
+};
+
+// the best one first, equal keys ordered by pid for stable results
+bool ranksBefore(const struct ranked_t& a, const struct ranked_t& b)
+{
+    if (a.value != b.value)
+        return a.value > b.value;
+    return a.pinfo.pid() < b.pinfo.pid();
+}
+
+} // namespace
+
+unsigned int rankKeyFields(enum rank_key key)
+{
+    switch (key)
+    {
+    case RANK_IO:
+        return FIELD_IO;
+    case RANK_CPU:
+    case RANK_RSS:
+    case RANK_CPU_TIME:
+    case RANK_MAJFLT:
+    default:
+        return FIELD_STAT;
+    }
+}
+
+double rankValue(ProcessInfo& pinfo, enum rank_key key)
+{
+    switch (key)
+    {
+    case RANK_CPU:
+        return pinfo.cpuUsage();
+    case RANK_RSS:
+        return pinfo.rss();
+    case RANK_IO:
+        return pinfo.ioTotalUsage();
+    case RANK_CPU_TIME:
+        return pinfo.utime() + pinfo.stime();
+    case RANK_MAJFLT:
+        return pinfo.majflt();
+    default:
+        return 0;
+    }
+}
+
+std::vector<ProcessInfo> topProcesses(enum rank_key key, size_t k, unsigned int fields)
+{
+    std::vector<ProcessInfo> top;
+    if (k == 0)
+        return top;
+
+    // heap with the weakest of the best k on top
+    std::vector<struct ranked_t> heap;
+    heap.reserve(k);
+    for (ProcessInfo& pinfo : ProcessRange(rankKeyFields(key)))
+    {
+        // the rates are computed for every process, to keep their previous sample
+        double value = rankValue(pinfo, key);
+        if (heap.size() == k)
+        {
+            struct ranked_t& weakest = heap.front();
+            if (value < weakest.value || (value == weakest.value && pinfo.pid() > weakest.pinfo.pid()))
+                continue;
+            std::pop_heap(heap.begin(), heap.end(), ranksBefore);
+            heap.pop_back();
+        }
+        heap.push_back(ranked_t{value, std::move(pinfo)});
+        std::push_heap(heap.begin(), heap.end(), ranksBefore);
+    }
+
+    std::sort_heap(heap.begin(), heap.end(), ranksBefore);
+    top.reserve(heap.size());
+    for (struct ranked_t& ranked : heap)
+    {
+        // the rest of the fields, for the winners only
+        ranked.pinfo.update(fields);
+        top.push_back(std::move(ranked.pinfo));
+    }
+    return top;
+}
@@ -0,0 +1,35 @@
+#ifndef TOPK_H
+#define TOPK_H
+
+#include <cstddef>
+#include <vector>
+
+#include "processinfo.h"
+
+// ranking keys of topProcesses()
+enum rank_key
+{
+    // cpuUsage(), 0 for a process seen for the first time
+    RANK_CPU,
+    // rss() in pages, from stat
+    RANK_RSS,
+    // ioTotalUsage(), 0 for a process seen for the first time
+    RANK_IO,
+    // utime + stime since the process started
+    RANK_CPU_TIME,
+    // majflt
+    RANK_MAJFLT
+};
+
+// field_group read during the scan to compute key
+unsigned int rankKeyFields(enum rank_key key);
+double rankValue(ProcessInfo& pinfo, enum rank_key key);
+
+// The k processes with the largest key, largest first
+//
+// The scan only reads the files needed by the key and keeps the best k in
+// a bounded heap, the other groups of fields are read for the winners
+// only. The usage keys are rates against the previous call, like top.
+std::vector<ProcessInfo> topProcesses(enum rank_key key, size_t k, unsigned int fields = FIELD_NONE);
+
+#endif // TOPK_H
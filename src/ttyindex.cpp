@@ -0,0 +1,137 @@
+#include <cstring>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+#include "ttyindex.h"
+#include "procfs.h"
+#include "instrumentation.h"
+
+// UNIX98 pty slaves, /dev/pts/<(major - 136) * 256 + minor>
+#define PTS_MAJOR_FIRST 136
+#define PTS_MAJOR_LAST 143
+
+// modification time of a directory, zero if it does not exist
+static struct timespec dirMtime(const char* path)
+{
+    struct stat st;
+    if (stat(path, &st) != 0)
+        return timespec();
+    return st.st_mtim;
+}
+
+static bool sameTime(const struct timespec& a, const struct timespec& b)
+{
+    return a.tv_sec == b.tv_sec && a.tv_nsec == b.tv_nsec;
+}
+
+// tty, tty0, tty12, ...
+static bool isTtyName(const char* name)
+{
+    if (strncmp(name, "tty", 3) != 0)
+        return false;
+    for (const char* c = name + 3; *c != '\0'; c++)
+        if (*c < '0' || *c > '9')
+            return false;
+    return true;
+}
+
+// add the character devices of a directory accepted by filter
+// they are named after /dev, whatever the dev root is
+static void scanDir(const std::string& path, const std::string& display_path,
+                    bool (*filter)(const char*), std::unordered_map<dev_t, std::string>& names)
+{
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr)
+        return;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr)
+    {
+        if (entry->d_name[0] == '.')
+            continue;
+        if (filter != nullptr && !filter(entry->d_name))
+            continue;
+        struct stat st;
+        if (fstatat(dirfd(dir), entry->d_name, &st, 0) == 0 && S_ISCHR(st.st_mode))
+            names.insert(std::make_pair(st.st_rdev, display_path + "/" + entry->d_name));
+    }
+    closedir(dir);
+}
+
+TtyIndex& TtyIndex::instance()
+{
+    static TtyIndex index;
+    return index;
+}
+
+TtyIndex::TtyIndex()
+    : m_dev_mtime(timespec()), m_pts_mtime(timespec())
+{
+    scan();
+}
+
+std::string TtyIndex::name(dev_t dev)
+{
+    if (dev == 0)
+        return std::string(); // no controlling terminal
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unordered_map<dev_t, std::string>::const_iterator it = m_names.find(dev);
+    if (it != m_names.end())
+        return it->second;
+    // a new pty does not change the mtime of /dev/pts
+    std::string pts_name = ptsName(dev);
+    if (!pts_name.empty())
+    {
+        m_names.insert(std::make_pair(dev, pts_name));
+        return pts_name;
+    }
+    // new terminal since the last scan ?
+    if (!changed())
+        return std::string();
+    scan();
+    it = m_names.find(dev);
+    if (it != m_names.end())
+        return it->second;
+    return std::string();
+}
+
+void TtyIndex::refresh()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    scan();
+}
+
+void TtyIndex::scan()
+{
+    SourceProbe probe(SOURCE_TTY_SCAN);
+    // take the times first, a change during the scan triggers a new one
+    std::string pts = devRoot() + "/pts";
+    m_dev_mtime = dirMtime(devRoot().c_str());
+    m_pts_mtime = dirMtime(pts.c_str());
+
+    m_names.clear();
+    scanDir(devRoot(), "/dev", isTtyName, m_names);
+    scanDir(pts, "/dev/pts", nullptr, m_names);
+}
+
+std::string TtyIndex::ptsName(dev_t dev) const
+{
+    unsigned int dev_major = major(dev);
+    if (dev_major < PTS_MAJOR_FIRST || dev_major > PTS_MAJOR_LAST)
+        return std::string();
+    std::string number = std::to_string((dev_major - PTS_MAJOR_FIRST) * 256 + minor(dev));
+    struct stat st;
+    std::string path = devRoot() + "/pts/" + number;
+    if (stat(path.c_str(), &st) != 0 || !S_ISCHR(st.st_mode) || st.st_rdev != dev)
+        return std::string();
+    return "/dev/pts/" + number;
+}
+
+bool TtyIndex::changed() const
+{
+    return !sameTime(m_dev_mtime, dirMtime(devRoot().c_str()))
+            || !sameTime(m_pts_mtime, dirMtime((devRoot() + "/pts").c_str()));
+}
@@ -0,0 +1,42 @@
+#ifndef TTYINDEX_H
+#define TTYINDEX_H
+
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <sys/types.h>
+
+// Maps a tty device number to its /dev path
+//
+// /dev/tty* and /dev/pts/* are scanned once and the index is shared by
+// every ProcessInfo. devpts does not update its mtime when a pseudo
+// terminal is allocated, so a miss on a UNIX98 pty major is resolved with
+// a stat of /dev/pts/<number>. Any other miss only triggers a new scan
+// when /dev or /dev/pts have been modified since the last one.
+class TtyIndex
+{
+public:
+    static TtyIndex& instance();
+
+    // empty string if dev is not a known tty
+    std::string name(dev_t dev);
+    // force a new scan
+    void refresh();
+
+private:
+    TtyIndex();
+
+    void scan();
+    // /dev/pts/<number> of a pty device, empty if it is not one
+    std::string ptsName(dev_t dev) const;
+    bool changed() const;
+
+    std::mutex m_mutex;
+    std::unordered_map<dev_t, std::string> m_names;
+    struct timespec m_dev_mtime;
+    struct timespec m_pts_mtime;
+};
+
+#endif // TTYINDEX_H
@@ -0,0 +1,209 @@
+#include <cerrno>
+#include <fstream>
+#include <vector>
+
+#include <grp.h>
+#include <pwd.h>
+#include <unistd.h>
+
+#include "usercache.h"
+#include "instrumentation.h"
+
+namespace {
+
+// retry delay after a failed NSS lookup
+const std::chrono::seconds ERROR_TTL(5);
+
+} // namespace
+
+UserCache& UserCache::instance()
+{
+    static UserCache cache;
+    return cache;
+}
+
+UserCache::UserCache()
+    : m_ttl(300),
+      m_negative_ttl(30),
+      m_source(NAME_SOURCE_NSS),
+      m_passwd_path("/etc/passwd"),
+      m_group_path("/etc/group")
+{
+
+}
+
+std::string UserCache::userName(uid_t uid)
+{
+    return lookup(m_users, uid, true);
+}
+
+std::string UserCache::groupName(gid_t gid)
+{
+    return lookup(m_groups, gid, false);
+}
+
+void UserCache::setTtl(std::chrono::seconds ttl)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_ttl = ttl;
+}
+
+void UserCache::setNegativeTtl(std::chrono::seconds ttl)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_negative_ttl = ttl;
+}
+
+void UserCache::setSource(enum name_source source, const std::string& passwd_path, const std::string& group_path)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_source = source;
+    m_passwd_path = passwd_path;
+    m_group_path = group_path;
+    // answers from the previous source are not valid anymore
+    m_users.clear();
+    m_groups.clear();
+    m_files_expires = std::chrono::steady_clock::time_point();
+}
+
+void UserCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_users.clear();
+    m_groups.clear();
+    m_files_expires = std::chrono::steady_clock::time_point();
+}
+
+std::string UserCache::lookup(name_map_t& cache, unsigned int id, bool user)
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    enum name_source source;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        name_map_t::const_iterator it = cache.find(id);
+        if (it != cache.end() && it->second.expires > now)
+            return it->second.name;
+        source = m_source;
+    }
+
+    // resolve without holding the lock, NSS can block for a while
+    std::string name;
+    enum resolve_result result;
+    SourceProbe probe(user ? SOURCE_USER_NAME : SOURCE_GROUP_NAME);
+    if (source == NAME_SOURCE_NSS)
+    {
+        result = resolveNss(id, user, name);
+    }
+    else
+    {
+        name = resolveFile(id, user);
+        result = name.empty() ? RESOLVE_UNKNOWN : RESOLVE_FOUND;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    struct name_entry_t& entry = cache[id];
+    entry.name = name;
+    switch (result)
+    {
+    case RESOLVE_FOUND:
+        entry.expires = now + m_ttl;
+        break;
+    case RESOLVE_UNKNOWN:
+        entry.expires = now + m_negative_ttl;
+        break;
+    case RESOLVE_ERROR:
+        entry.expires = now + ERROR_TTL;
+        break;
+    }
+    return name;
+}
+
+enum UserCache::resolve_result UserCache::resolveNss(unsigned int id, bool user, std::string& name)
+{
+    long size = sysconf(user ? _SC_GETPW_R_SIZE_MAX : _SC_GETGR_R_SIZE_MAX);
+    if (size <= 0)
+        size = 1024;
+    std::vector<char> buf(size);
+    while (true)
+    {
+        int rc;
+        const char* found = nullptr;
+        if (user)
+        {
+            struct passwd pwd;
+            struct passwd* result = nullptr;
+            rc = getpwuid_r(id, &pwd, buf.data(), buf.size(), &result);
+            if (rc == 0 && result != nullptr)
+                found = result->pw_name;
+        }
+        else
+        {
+            struct group grp;
+            struct group* result = nullptr;
+            rc = getgrgid_r(id, &grp, buf.data(), buf.size(), &result);
+            if (rc == 0 && result != nullptr)
+                found = result->gr_name;
+        }
+        if (rc == ERANGE)
+        {
+            // entry does not fit (huge group member list)
+            buf.resize(buf.size() * 2);
+            continue;
+        }
+        if (rc == EINTR)
+            continue;
+        name.clear();
+        if (rc != 0)
+            return RESOLVE_ERROR;
+        // only rc == 0 without an entry means the id does not exist
+        if (found == nullptr)
+            return RESOLVE_UNKNOWN;
+        name = found;
+        return RESOLVE_FOUND;
+    }
+}
+
+std::string UserCache::resolveFile(unsigned int id, bool user)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (now >= m_files_expires)
+    {
+        loadFile(m_passwd_path, m_passwd);
+        loadFile(m_group_path, m_group);
+        m_files_expires = now + m_ttl;
+    }
+    const std::unordered_map<unsigned int, std::string>& names = user ? m_passwd : m_group;
+    std::unordered_map<unsigned int, std::string>::const_iterator it = names.find(id);
+    if (it == names.end())
+        return std::string();
+    return it->second;
+}
+
+void UserCache::loadFile(const std::string& path, std::unordered_map<unsigned int, std::string>& names)
+{
+    names.clear();
+    std::ifstream if_file(path);
+    // line sample, same layout for passwd and group
+    // root:x:0:0:root:/root:/bin/bash
+    std::string line;
+    while (std::getline(if_file, line))
+    {
+        if (line.empty() || line[0] == '#')
+            continue;
+        size_t name_end = line.find(':');
+        if (name_end == std::string::npos)
+            continue;
+        size_t id_begin = line.find(':', name_end + 1);
+        if (id_begin == std::string::npos)
+            continue;
+        id_begin++;
+        size_t id_end = line.find(':', id_begin);
+        std::string id = line.substr(id_begin, id_end - id_begin);
+        if (id.empty() || id.find_first_not_of("0123456789") != std::string::npos)
+            continue;
+        // the first entry wins, like getpwuid
+        names.insert(std::make_pair(std::stoul(id), line.substr(0, name_end)));
+    }
+    if_file.close();
+}
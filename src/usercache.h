@@ -0,0 +1,80 @@
+#ifndef USERCACHE_H
+#define USERCACHE_H
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <sys/types.h>
+
+enum name_source
+{
+    // getpwuid_r / getgrgid_r, goes through NSS (LDAP, SSSD, ...)
+    NAME_SOURCE_NSS,
+    // parse the passwd and group files only
+    NAME_SOURCE_FILES
+};
+
+// Process wide uid -> user name and gid -> group name cache
+//
+// Every name is kept for ttl, and an unknown id for the shorter
+// negative_ttl, so that a slow NSS backend is queried at most once per id
+// and per ttl. A failed lookup (EIO, backend timeout...) is only kept for a
+// few seconds, a transient error must not hide a name for a whole ttl. All
+// the methods can be called from several threads, and no lock is held
+// while NSS is queried.
+class UserCache
+{
+public:
+    static UserCache& instance();
+
+    // empty string if the id is unknown
+    std::string userName(uid_t uid);
+    std::string groupName(gid_t gid);
+
+    void setTtl(std::chrono::seconds ttl);
+    void setNegativeTtl(std::chrono::seconds ttl);
+    void setSource(enum name_source source,
+                   const std::string& passwd_path = "/etc/passwd",
+                   const std::string& group_path = "/etc/group");
+    void clear();
+
+private:
+    struct name_entry_t
+    {
+        std::string name;
+        std::chrono::steady_clock::time_point expires;
+    };
+    typedef std::unordered_map<unsigned int, struct name_entry_t> name_map_t;
+
+    UserCache();
+
+    // outcome of a resolve, picks the ttl
+    enum resolve_result
+    {
+        RESOLVE_FOUND,
+        RESOLVE_UNKNOWN,
+        RESOLVE_ERROR
+    };
+
+    std::string lookup(name_map_t& cache, unsigned int id, bool user);
+    enum resolve_result resolveNss(unsigned int id, bool user, std::string& name);
+    std::string resolveFile(unsigned int id, bool user);
+    void loadFile(const std::string& path, std::unordered_map<unsigned int, std::string>& names);
+
+    std::mutex m_mutex;
+    std::chrono::seconds m_ttl;
+    std::chrono::seconds m_negative_ttl;
+    enum name_source m_source;
+    std::string m_passwd_path;
+    std::string m_group_path;
+    name_map_t m_users;
+    name_map_t m_groups;
+    // NAME_SOURCE_FILES content, reloaded when the ttl expires
+    std::unordered_map<unsigned int, std::string> m_passwd;
+    std::unordered_map<unsigned int, std::string> m_group;
+    std::chrono::steady_clock::time_point m_files_expires;
+};
+
+#endif // USERCACHE_H
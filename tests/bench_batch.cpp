@@ -0,0 +1,91 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+#include <sysinfo.h>
+#include <procfs.h>
+#include <batchreader.h>
+
+// Compares the synchronous scan with the io_uring batched one
+//
+// usage: bench_batch [proc_root]
+//   the tree written by tools/gen_procfs gives a scan at a given scale
+//
+// The raw rows read the stat, status and io files of every process with
+// BatchReader, once falling back to open/read/close and once through
+// io_uring, and count the syscalls made for the files. The scan rows time
+// processList() against processListBatched() for the same fields.
+
+static double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::vector<struct batch_read_t> statFiles()
+{
+    std::vector<struct batch_read_t> reads;
+    for (int pid : processListPid())
+    {
+        std::string proc_path = procPath(std::to_string(pid)) + "/";
+        for (const char* file : {"stat", "status", "io"})
+        {
+            struct batch_read_t read;
+            read.path = proc_path + file;
+            reads.push_back(read);
+        }
+    }
+    return reads;
+}
+
+// syscalls < 0 when not counted
+static void report(const std::string& name, size_t files, double ms, long syscalls)
+{
+    std::cout << std::left << std::setw(24) << name << std::right << std::setw(10) << files << std::setw(12)
+              << std::fixed << std::setprecision(2) << ms << std::setw(12);
+    if (syscalls < 0)
+        std::cout << "-" << std::endl;
+    else
+        std::cout << syscalls << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+        setProcRoot(argv[1]);
+    const int iterations = 10;
+    const unsigned int fields = FIELD_STAT | FIELD_STATUS | FIELD_IO;
+
+    BatchReader uring;
+    // a depth of 0 disables io_uring
+    BatchReader sync(0);
+    if (!uring.isUring())
+        std::cout << "io_uring unavailable, both paths are synchronous" << std::endl;
+
+    std::cout << std::left << std::setw(24) << "benchmark" << std::right << std::setw(10) << "files"
+              << std::setw(12) << "ms/op" << std::setw(12) << "syscalls/op" << std::endl;
+
+    std::vector<struct batch_read_t> reads = statFiles();
+    for (BatchReader* reader : {&sync, &uring})
+    {
+        reader->read(reads);
+        unsigned long syscalls = reader->syscalls();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++)
+            reader->read(reads);
+        report(reader == &sync ? "read(open/read/close)" : "read(io_uring)", reads.size(),
+               elapsedMs(start) / iterations, (reader->syscalls() - syscalls) / iterations);
+    }
+
+    size_t processes = 0;
+    processList(fields);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        processes = processList(fields).size();
+    report("processList", processes * 3, elapsedMs(start) / iterations, -1);
+
+    processListBatched(fields);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        processes = processListBatched(fields).size();
+    report("processListBatched", processes * 3, elapsedMs(start) / iterations, -1);
+}
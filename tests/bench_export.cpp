@@ -0,0 +1,94 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+#include <sysinfo.h>
+#include <exporter.h>
+
+static const size_t NB_PROCESSES = 30000;
+static const int NB_ROUNDS = 20;
+
+static std::atomic<unsigned long> s_allocations(0);
+
+void* operator new(size_t size)
+{
+    s_allocations++;
+    void* ptr = malloc(size);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+static void report(const std::string& label, const struct snapshot_view_t& snapshot,
+                   void (*exporter)(const struct snapshot_view_t&, OutputBuffer&))
+{
+    OutputBuffer out;
+    // warm up, the buffer grows to the size of a snapshot
+    exporter(snapshot, out);
+
+    size_t bytes = 0;
+    unsigned long allocations = s_allocations;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int round = 0; round < NB_ROUNDS; round++)
+    {
+        out.clear();
+        exporter(snapshot, out);
+        bytes += out.size();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    allocations = s_allocations - allocations;
+
+    std::cout << label << " : " << out.size() / snapshot.count << " B/process, "
+              << bytes / elapsed.count() / (1 << 20) << " MiB/s, "
+              << elapsed.count() / NB_ROUNDS * 1000 << " ms/snapshot, "
+              << allocations << " allocations" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    // the live process table, repeated up to NB_PROCESSES
+    std::vector<ProcessInfo> processes = processList(SNAPSHOT_FIELDS);
+    StringTable strings;
+    std::vector<struct process_record_t> live(processes.size());
+    for (size_t i = 0; i < processes.size(); i++)
+        fillRecord(processes[i], live[i], strings);
+    if (live.empty())
+        return 1;
+    std::vector<struct process_record_t> records;
+    for (size_t i = 0; records.size() < NB_PROCESSES; i++)
+    {
+        records.push_back(live[i % live.size()]);
+        records.back().pid = i + 1;
+    }
+    struct snapshot_view_t snapshot = makeSnapshotView(records, strings, std::chrono::system_clock::now());
+
+    if (argc > 1)
+    {
+        // print the first processes in the given format
+        OutputBuffer out;
+        snapshot.count = 3;
+        if (std::string(argv[1]) == "prometheus")
+            exportPrometheus(snapshot, out);
+        else
+            exportNdjson(snapshot, out);
+        out.flush(1);
+        return 0;
+    }
+
+    std::cout << NB_PROCESSES << " processes" << std::endl;
+    report("ndjson", snapshot, exportNdjson);
+    report("prometheus", snapshot, exportPrometheus);
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include <timeseries.h>
+
+// one hour at 1 Hz
+static const size_t NB_SAMPLES = 3600;
+static const int NB_ROUNDS = 200;
+
+struct series_t
+{
+    std::string label;
+    std::vector<int64_t> timestamps;
+    std::vector<uint64_t> values;
+};
+
+// 1 Hz timestamps in ms with a few ms of scheduling jitter
+static std::vector<int64_t> timestamps(std::mt19937& rng)
+{
+    std::uniform_int_distribution<int> jitter(-3, 3);
+    std::vector<int64_t> result;
+    int64_t now = 1700000000000;
+    for (size_t i = 0; i < NB_SAMPLES; i++)
+        result.push_back(now + i * 1000 + jitter(rng));
+    return result;
+}
+
+static std::vector<series_t> workload()
+{
+    std::mt19937 rng(42);
+    std::vector<series_t> series;
+
+    // utime of a busy process, about 50 ticks per second
+    series_t utime = {"utime (busy)", timestamps(rng), {}};
+    std::poisson_distribution<int> ticks(50);
+    uint64_t value = 123456;
+    for (size_t i = 0; i < NB_SAMPLES; i++)
+        utime.values.push_back(value += ticks(rng));
+    series.push_back(utime);
+
+    // utime of an idle process
+    series_t idle = {"utime (idle)", timestamps(rng), {}};
+    std::bernoulli_distribution tick(0.02);
+    value = 42;
+    for (size_t i = 0; i < NB_SAMPLES; i++)
+        idle.values.push_back(value += tick(rng));
+    series.push_back(idle);
+
+    // VmRSS in kB, changing now and then
+    series_t rss = {"vm_rss", timestamps(rng), {}};
+    std::bernoulli_distribution change(0.05);
+    std::uniform_int_distribution<int> pages(-64, 64);
+    value = 512000;
+    for (size_t i = 0; i < NB_SAMPLES; i++)
+        rss.values.push_back(value += change(rng) ? pages(rng) * 4 : 0);
+    series.push_back(rss);
+
+    // read_bytes with bursts
+    series_t io = {"read_bytes", timestamps(rng), {}};
+    std::bernoulli_distribution burst(0.1);
+    std::uniform_int_distribution<uint64_t> bytes(4096, 64 << 20);
+    value = 1ULL << 30;
+    for (size_t i = 0; i < NB_SAMPLES; i++)
+        io.values.push_back(value += burst(rng) ? bytes(rng) : 0);
+    series.push_back(io);
+
+    return series;
+}
+
+int main()
+{
+    std::vector<series_t> series = workload();
+    // a raw sample is a 64 bits timestamp and a 64 bits value
+    std::cout << "raw : 16 B/sample" << std::endl;
+
+    for (const series_t& s : series)
+    {
+        TimeSeriesEncoder encoder;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int round = 0; round < NB_ROUNDS; round++)
+        {
+            encoder.clear();
+            for (size_t i = 0; i < NB_SAMPLES; i++)
+                encoder.append(s.timestamps[i], s.values[i]);
+        }
+        std::chrono::duration<double> encode_time = std::chrono::steady_clock::now() - start;
+
+        size_t errors = 0;
+        start = std::chrono::steady_clock::now();
+        for (int round = 0; round < NB_ROUNDS; round++)
+        {
+            TimeSeriesDecoder decoder(encoder);
+            int64_t timestamp;
+            uint64_t value;
+            for (size_t i = 0; decoder.next(timestamp, value); i++)
+                if (timestamp != s.timestamps[i] || value != s.values[i])
+                    errors++;
+        }
+        std::chrono::duration<double> decode_time = std::chrono::steady_clock::now() - start;
+
+        double nb_total = static_cast<double>(NB_SAMPLES) * NB_ROUNDS;
+        std::cout << s.label << " : "
+                  << static_cast<double>(encoder.data().size()) / NB_SAMPLES << " B/sample, "
+                  << "encode " << nb_total / encode_time.count() / 1e6 << " M samples/s, "
+                  << "decode " << nb_total / decode_time.count() / 1e6 << " M samples/s"
+                  << (errors ? ", MISMATCH" : "") << std::endl;
+    }
+    return 0;
+}
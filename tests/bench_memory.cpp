@@ -0,0 +1,38 @@
+#include <iostream>
+#include <malloc.h>
+
+#include <sysinfo.h>
+
+// heap currently in use
+static size_t heapUsed()
+{
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+static void report(const std::string& label, unsigned int fields)
+{
+    size_t before = heapUsed();
+    std::vector<ProcessInfo> process_list = processList(fields);
+    size_t after = heapUsed();
+
+    size_t nb_process = process_list.size();
+    if (nb_process == 0)
+        return;
+    size_t arena_bytes = process_list[0].arena()->bytes();
+    std::cout << label << " : " << nb_process << " processes, "
+              << (after - before) / nb_process << " B/process"
+              << " (arena " << arena_bytes << " B, "
+              << process_list[0].arena()->count() << " strings)" << std::endl;
+}
+
+int main()
+{
+    std::cout << "sizeof(ProcessInfo) : " << sizeof(ProcessInfo) << " B" << std::endl;
+    std::cout << "sizeof(MMap) : " << sizeof(MMap) << " B" << std::endl;
+
+    report("stat", FIELD_STAT);
+    report("stat + status + io", FIELD_STAT | FIELD_STATUS | FIELD_IO);
+    report("full snapshot", FIELD_ALL);
+    return 0;
+}
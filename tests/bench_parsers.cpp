@@ -0,0 +1,179 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <sysinfo.h>
+#include <procfs.h>
+#include <procbackend.h>
+#include <procstat.h>
+
+// Runs every parser and scan path against the live system, and the pure
+// parsers against the recorded inputs of tests/data, then reports for
+// each one the time, heap allocations and read/write syscalls per call.
+//
+// usage: bench_parsers [pid] [proc_root | archive]
+//   pid defaults to this process, proc_root to /proc, the tree written by
+//   tools/gen_procfs can be given to measure a scan at a given scale, or a
+//   RecordingBackend archive to replay the scan of another host
+//
+// The syscalls are the syscr + syscw counters of /proc/self/io: openat,
+// close and getdents64 are not counted there.
+
+static std::atomic<unsigned long> s_allocations(0);
+
+void* operator new(size_t size)
+{
+    s_allocations++;
+    void* ptr = malloc(size);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+// syscr + syscw of this process, read without allocating
+static unsigned long syscallCount()
+{
+    char buf[512];
+    ssize_t len = readFileAt(AT_FDCWD, "/proc/self/io", buf, sizeof(buf) - 1);
+    if (len <= 0)
+        return 0;
+    buf[len] = '\0';
+    unsigned long count = 0;
+    for (const char* key : {"syscr: ", "syscw: "})
+    {
+        const char* value = strstr(buf, key);
+        if (value != nullptr)
+            count += strtoul(value + strlen(key), nullptr, 10);
+    }
+    return count;
+}
+
+// syscalls done by syscallCount() itself
+static unsigned long s_syscall_overhead = 0;
+
+template <typename Operation>
+static void bench(const std::string& name, const std::string& source, int iterations, Operation operation)
+{
+    // warm up, fills the caches (tty index, user names, ...)
+    operation();
+
+    unsigned long allocations = s_allocations;
+    unsigned long syscalls = syscallCount();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        operation();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    syscalls = syscallCount() - syscalls - s_syscall_overhead;
+    allocations = s_allocations - allocations;
+
+    std::cout << std::left << std::setw(20) << name << std::setw(10) << source << std::right
+              << std::fixed << std::setprecision(0) << std::setw(14) << elapsed.count() / iterations
+              << std::setprecision(1) << std::setw(14) << static_cast<double>(allocations) / iterations
+              << std::setw(14) << static_cast<double>(syscalls) / iterations << std::endl;
+}
+
+static std::string readData(const std::string& name)
+{
+    std::ifstream file(std::string(TESTS_DATA_DIR) + "/" + name);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+// same splitting as ProcessInfo::readSmaps()
+static void parseSmaps(const std::string& smaps, StringArena& arena, std::vector<MMap>& maps)
+{
+    maps.clear();
+    std::istringstream input(smaps);
+    std::string line;
+    std::stringstream map_stream;
+    while (std::getline(input, line))
+    {
+        if (line.find('-') != std::string::npos && !map_stream.str().empty())
+        {
+            maps.push_back(MMap(map_stream, arena));
+            map_stream.clear();
+            map_stream.str("");
+        }
+        map_stream << line << "\n";
+    }
+    maps.push_back(MMap(map_stream, arena));
+}
+
+// read one field group of pinfo again
+static void reread(ProcessInfo& pinfo, unsigned int fields)
+{
+    pinfo.needUpdate();
+    pinfo.update(fields);
+}
+
+int main(int argc, char* argv[])
+{
+    pid_t pid = argc > 1 ? atoi(argv[1]) : getpid();
+    std::string live = "live";
+    struct stat st;
+    if (argc > 2 && stat(argv[2], &st) == 0 && S_ISREG(st.st_mode))
+    {
+        setProcBackend(std::make_shared<ReplayBackend>(argv[2]));
+        live = "replay";
+    }
+    else if (argc > 2)
+    {
+        setProcRoot(argv[2]);
+        live = "fixture";
+    }
+
+    unsigned long before = syscallCount();
+    s_syscall_overhead = syscallCount() - before;
+
+    std::cout << std::left << std::setw(20) << "benchmark" << std::setw(10) << "source" << std::right
+              << std::setw(14) << "ns/op" << std::setw(14) << "allocs/op" << std::setw(14) << "syscalls/op"
+              << std::endl;
+
+    // live
+    ProcessInfo pinfo(pid);
+    bench("readStat", live, 10000, [&]() { reread(pinfo, FIELD_STAT); });
+    bench("readStatus", live, 10000, [&]() { reread(pinfo, FIELD_STATUS); });
+    bench("readIo", live, 10000, [&]() { reread(pinfo, FIELD_IO); });
+    bench("readSmaps", live, 200, [&]() { reread(pinfo, FIELD_SMAPS); });
+    bench("readFd", live, 2000, [&]() { reread(pinfo, FIELD_FD); });
+    bench("readLimits", live, 10000, [&]() { reread(pinfo, FIELD_LIMITS); });
+    bench("readCPUInfo", live, 1000, []() { readCPUInfo(); });
+    bench("processListPid", live, 1000, []() { processListPid(); });
+    bench("processList", live, 20, []() { processList(); });
+    bench("processList(stat)", live, 20, []() { processList(FIELD_STAT); });
+    bench("processList(top)", live, 20, []() { processList(FIELD_STAT | FIELD_STATUS | FIELD_CMDLINE); });
+    bench("topProcesses(rss)", live, 20, []() { topProcesses(RANK_RSS, 20, FIELD_STATUS | FIELD_CMDLINE); });
+    bench("getSocketTCP", live, 1000, []() { getSocketTCP(); });
+    bench("getSocketUNIX", live, 1000, []() { getSocketUNIX(); });
+
+    // recorded
+    std::string stat = readData("stat");
+    struct proc_stat_t proc_stat;
+    bench("parseStat", "recorded", 1000000, [&]() { parseStat(stat.data(), stat.size(), proc_stat); });
+    std::string smaps = readData("smaps");
+    StringArena arena;
+    std::vector<MMap> maps;
+    bench("MMap", "recorded", 10000, [&]() { parseSmaps(smaps, arena, maps); });
+    return 0;
+}
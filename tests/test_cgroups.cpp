@@ -0,0 +1,34 @@
+#include <iostream>
+#include <iomanip>
+#include <unistd.h>
+#include <sysinfo.h>
+#include <procfs.h>
+
+// usage: test_cgroups [cgroup_root]
+// groups the running processes by cgroup v2 and prints the accounting of
+// each cgroup twice, one second apart
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+        setCgroupRoot(argv[1]);
+    std::cout << "cgroup v2 root " << cgroupRoot() << std::endl;
+
+    std::vector<ProcessInfo> processes = processList(FIELD_CGROUP);
+    CgroupReader reader;
+    reader.add("/");
+    reader.addProcesses(processes);
+
+    for (int i = 0; i < 2; i++)
+    {
+        reader.sample();
+        for (const std::string& path : reader.paths())
+        {
+            const struct cgroup_stat_t* stat = reader.stat(path);
+            std::cout << std::setw(6) << stat->pids.size() << std::setw(14) << stat->usage_usec << " us"
+                      << std::setw(12) << stat->memory_current / 1024 << " kB" << std::setw(12)
+                      << (stat->rbytes + stat->wbytes) / 1024 << " kB io" << std::setw(6) << stat->pids_current
+                      << " pids  files 0x" << std::hex << stat->available << std::dec << "  " << path << std::endl;
+        }
+        sleep(1);
+    }
+}
@@ -1,12 +1,15 @@
+#include <cstdlib>
 #include <iostream>
 #include <sysinfo.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include <boost/algorithm/string/join.hpp>
 
-int main()
+// usage: test_cpu_usage [pid] (default: this process)
+int main(int argc, char* argv[])
 {
-    ProcessInfo pinfo(17897);
+    pid_t pid = argc > 1 ? atoi(argv[1]) : getpid();
+    ProcessInfo pinfo(pid);
     while (1)
     {
         std::cout << "cpu_usage : " << pinfo.cpuUsage() <<  std::endl;
@@ -0,0 +1,63 @@
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+#include <sysinfo.h>
+#include <deltastream.h>
+
+// encodes nb_frames snapshots, one per second, then decodes them and
+// checks they match what was encoded
+int main(int argc, char* argv[])
+{
+    int nb_frames = argc > 1 ? atoi(argv[1]) : 5;
+    FILE* file = tmpfile();
+    int fd = fileno(file);
+
+    std::vector<std::vector<struct process_record_t>> expected_records;
+    std::vector<StringTable> expected_strings;
+    DeltaEncoder encoder(fd, 3);
+    for (int i = 0; i < nb_frames; i++)
+    {
+        std::vector<ProcessInfo> processes = processList(SNAPSHOT_FIELDS);
+        std::vector<struct process_record_t> records(processes.size());
+        StringTable strings;
+        for (size_t j = 0; j < processes.size(); j++)
+            fillRecord(processes[j], records[j], strings);
+        encoder.write(records, strings, std::chrono::system_clock::now());
+        std::cout << "frame " << i << " : " << encoder.lastFrameSize() << " B, full snapshot "
+                  << records.size() * sizeof(struct process_record_t) + strings.data().size() << " B" << std::endl;
+        expected_records.push_back(records);
+        expected_strings.push_back(strings);
+        sleep(1);
+    }
+
+    lseek(fd, 0, SEEK_SET);
+    DeltaDecoder decoder(fd);
+    std::vector<struct process_record_t> records;
+    StringTable strings;
+    std::chrono::system_clock::time_point time;
+    int frame = 0;
+    int errors = 0;
+    while (decoder.next(records, strings, time))
+    {
+        const std::vector<struct process_record_t>& expected = expected_records[frame];
+        const std::string& expected_table = expected_strings[frame].data();
+        if (records.size() != expected.size())
+            errors++;
+        for (size_t j = 0; j < records.size() && j < expected.size(); j++)
+        {
+            struct process_record_t a = records[j];
+            struct process_record_t b = expected[j];
+            if (strings.data().substr(a.cmdline).c_str() != std::string(expected_table.c_str() + b.cmdline)
+                    || strings.data().substr(a.name).c_str() != std::string(expected_table.c_str() + b.name))
+                errors++;
+            a.name = a.exe = a.cmdline = b.name = b.exe = b.cmdline = 0;
+            if (memcmp(&a, &b, sizeof(a)) != 0)
+                errors++;
+        }
+        frame++;
+    }
+    std::cout << frame << " frames decoded, " << errors << " mismatches" << std::endl;
+    fclose(file);
+    return errors ? 1 : 0;
+}
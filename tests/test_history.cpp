@@ -0,0 +1,24 @@
+#include <cstdlib>
+#include <iostream>
+#include <unistd.h>
+#include <sysinfo.h>
+#include <historystore.h>
+
+int main(int argc, char* argv[])
+{
+    pid_t pid = argc > 1 ? atoi(argv[1]) : getpid();
+    // 5 minutes at 1 Hz
+    HistoryStore history(300, (1 << METRIC_CPU_USAGE) | (1 << METRIC_VM_RSS));
+    ProcessInfo pinfo(pid);
+    while (1)
+    {
+        history.record(pinfo);
+        pinfo.needUpdate();
+
+        struct window_stat_t rss = history.stats(pid, METRIC_VM_RSS, std::chrono::minutes(5));
+        std::cout << "rss min " << rss.min << " max " << rss.max << " avg " << rss.avg
+                  << " kB, cpu p95 " << history.percentile(pid, METRIC_CPU_USAGE, 95, std::chrono::minutes(5))
+                  << " over " << rss.count << " samples" << std::endl;
+        sleep(1);
+    }
+}
@@ -0,0 +1,32 @@
+#include <iostream>
+#include <iomanip>
+#include <sysinfo.h>
+#include <instrumentation.h>
+
+int main()
+{
+    setInstrumentation(true);
+    processList(FIELD_ALL);
+    getSocketTCP();
+    getSocketUNIX();
+
+    std::cout << std::setw(12) << "source" << std::setw(8) << "calls" << std::setw(9) << "vanished"
+              << std::setw(8) << "denied" << std::setw(8) << "failed"
+              << std::setw(12) << "bytes" << std::setw(12) << "read us" << std::setw(12) << "parse us"
+              << "  p50 bucket" << std::endl;
+    for (int i = 0; i < SOURCE_COUNT; i++)
+    {
+        struct source_stats_t stats = sourceStats(static_cast<enum data_source>(i));
+        if (stats.calls == 0)
+            continue;
+        // first bucket reaching half of the calls
+        unsigned long seen = 0;
+        int median = 0;
+        while (median < LATENCY_BUCKETS - 1 && (seen += stats.latency[median]) * 2 < stats.calls)
+            median++;
+        std::cout << std::setw(12) << sourceName(static_cast<enum data_source>(i)) << std::setw(8) << stats.calls
+                  << std::setw(9) << stats.vanished << std::setw(8) << stats.denied << std::setw(8) << stats.failures << std::setw(12) << stats.bytes << std::setw(12)
+                  << stats.read_ns / 1000 << std::setw(12) << stats.parse_ns / 1000 << "  < " << (1UL << (median + 1))
+                  << " ns" << std::endl;
+    }
+}
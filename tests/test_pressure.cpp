@@ -0,0 +1,47 @@
+#include <iostream>
+#include <iomanip>
+#include <sysinfo.h>
+
+// usage: test_pressure [seconds]
+// prints the system and root cgroup pressure, then waits for a cpu stall
+// of 100 ms within 2 s for the given time
+
+static void print(const std::string& name, const struct pressure_t& pressure)
+{
+    std::cout << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(2)
+              << " some " << std::setw(6) << pressure.some.avg10 << std::setw(7) << pressure.some.avg60
+              << std::setw(7) << pressure.some.avg300 << std::setw(14) << pressure.some.total
+              << "  full " << std::setw(6) << pressure.full.avg10 << std::setw(7) << pressure.full.avg60
+              << std::setw(7) << pressure.full.avg300 << std::setw(14) << pressure.full.total << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    for (int i = 0; i < PRESSURE_RESOURCE_COUNT; i++)
+    {
+        enum pressure_resource resource = static_cast<enum pressure_resource>(i);
+        struct pressure_t pressure;
+        if (readPressure(resource, pressure))
+            print(pressureName(resource), pressure);
+        if (readCgroupPressure("/", resource, pressure))
+            print(std::string("cgroup / ") + pressureName(resource), pressure);
+    }
+
+    if (argc > 1)
+    {
+        PressureMonitor monitor;
+        try {
+            monitor.addTrigger(PRESSURE_CPU, false, std::chrono::milliseconds(100), std::chrono::seconds(2));
+        } catch (const std::string& e)
+        {
+            std::cerr << "cannot add the trigger: " << e << std::endl;
+            return 1;
+        }
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::seconds(atoi(argv[1]));
+        while (std::chrono::steady_clock::now() < end)
+        {
+            if (!monitor.wait(std::chrono::milliseconds(500)).empty())
+                std::cout << "cpu stall" << std::endl;
+        }
+    }
+}
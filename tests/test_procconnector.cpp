@@ -46,7 +46,7 @@ void handler(struct proc_event event)
 
 }
 
-int main(int argc, char* argv[])
+int main()
 {
     ProcConnector connector = ProcConnector();
     connector.addCallback(handler);
@@ -0,0 +1,32 @@
+#include <chrono>
+#include <iostream>
+#include <unistd.h>
+#include <sysinfo.h>
+
+// usage: test_process_range [name]
+// streams the processes and stops at the first one named name
+int main(int argc, char* argv[])
+{
+    std::string name = argc > 1 ? argv[1] : ProcessInfo(getpid(), FIELD_STAT).name();
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    ProcessRange range(FIELD_STAT);
+    ProcessRange::iterator it = range.begin();
+    std::chrono::steady_clock::duration first = std::chrono::steady_clock::now() - start;
+
+    int scanned = 0;
+    for (; it != range.end(); ++it)
+    {
+        scanned++;
+        if (it->name() == name)
+        {
+            std::cout << "found " << name << " pid " << it->pid() << " after " << scanned << " processes" << std::endl;
+            break;
+        }
+    }
+    if (it == range.end())
+        std::cout << name << " not found in " << scanned << " processes" << std::endl;
+    std::cout << "first process after "
+              << std::chrono::duration_cast<std::chrono::microseconds>(first).count() << " us, "
+              << processCount() << " running" << std::endl;
+}
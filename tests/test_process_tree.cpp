@@ -0,0 +1,44 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <unistd.h>
+#include <sysinfo.h>
+
+// usage: test_process_tree [seconds]
+// prints the tree with the usage of each subtree, then follows the fork
+// and exit events for the given time (needs CAP_NET_ADMIN)
+
+static void print(ProcessTree& tree, pid_t pid, int depth)
+{
+    struct tree_usage_t usage = tree.subtreeUsage(pid);
+    std::cout << std::setw(8) << pid << std::setw(6) << usage.processes << std::setw(6) << usage.threads
+              << std::setw(10) << usage.rss << " kB " << std::setw(4) << usage.cpu << "% "
+              << std::string(depth * 2, ' ') << ProcessInfo(pid).name() << std::endl;
+    for (pid_t child : tree.children(pid))
+        print(tree, child, depth + 1);
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<ProcessInfo> processes = processList(FIELD_STAT);
+    ProcessTree tree(processes);
+
+    std::cout << std::setw(8) << "pid" << std::setw(6) << "procs" << std::setw(6) << "thrs" << std::setw(13)
+              << "rss" << std::setw(6) << "cpu" << std::endl;
+    long total = 0;
+    for (pid_t root : tree.roots())
+    {
+        print(tree, root, 0);
+        total += tree.subtreeUsage(root).processes;
+    }
+    std::cout << total << " processes in the subtrees, " << tree.size() << " in the tree" << std::endl;
+
+    if (argc > 1)
+    {
+        ProcConnector connector;
+        connector.addCallback([&tree](struct proc_event event) { tree.onEvent(event); });
+        connector.listen();
+        sleep(atoi(argv[1]));
+        std::cout << tree.size() << " processes after the events" << std::endl;
+    }
+}
@@ -0,0 +1,37 @@
+#include <iostream>
+#include <iomanip>
+#include <unistd.h>
+#include <sysinfo.h>
+
+// prints, for each process with some activity, the per second rates of
+// the counters over one second
+int main()
+{
+    RateTracker tracker;
+    std::vector<ProcessInfo> first = processList(tracker.fields());
+    tracker.sample(first);
+    sleep(1);
+    std::vector<ProcessInfo> processes = processList(tracker.fields());
+    tracker.sample(processes);
+
+    const enum rate_counter shown[] = { COUNTER_MINFLT, COUNTER_UTIME, COUNTER_SYSCR, COUNTER_SYSCW, COUNTER_RCHAR,
+                                        COUNTER_WCHAR, COUNTER_VOLUNTARY_CTXT_SWITCHES,
+                                        COUNTER_NONVOLUNTARY_CTXT_SWITCHES };
+    std::cout << std::setw(8) << "pid" << std::setw(10) << "minflt/s" << std::setw(10) << "ticks/s" << std::setw(10)
+              << "syscr/s" << std::setw(10) << "syscw/s" << std::setw(12) << "rchar/s" << std::setw(12) << "wchar/s"
+              << std::setw(10) << "vcsw/s" << std::setw(10) << "nvcsw/s" << std::endl;
+    const std::vector<pid_t>& pids = tracker.pids();
+    for (size_t i = 0; i < pids.size(); i++)
+    {
+        double activity = 0;
+        for (enum rate_counter counter : shown)
+            activity += tracker.rates(counter)[i];
+        if (activity == 0)
+            continue;
+        std::cout << std::setw(8) << pids[i] << std::fixed << std::setprecision(0);
+        for (enum rate_counter counter : shown)
+            std::cout << std::setw(counter == COUNTER_RCHAR || counter == COUNTER_WCHAR ? 12 : 10)
+                      << tracker.rates(counter)[i];
+        std::cout << "  " << processes[i].name() << std::endl;
+    }
+}
@@ -0,0 +1,48 @@
+#include <iostream>
+#include <sstream>
+#include <sysinfo.h>
+#include <procbackend.h>
+
+// usage: test_record_replay <archive>
+// records a full scan of the live system into archive, replays it and
+// checks that both scans read the same content
+static std::string scan()
+{
+    std::stringstream out;
+    std::vector<ProcessInfo> processes = processList(FIELD_ALL);
+    for (ProcessInfo& pinfo : processes)
+        out << pinfo.pid() << " " << pinfo.name() << " " << pinfo.state() << " " << pinfo.vmRss()
+            << " " << pinfo.readBytes() << " " << pinfo.exe() << " " << pinfo.fdCount()
+            << " " << pinfo.maps().size() << " " << pinfo.cmdline().size() << std::endl;
+    out << getSocketTCP().size() << " tcp sockets, " << getSocketUNIX().size() << " unix sockets, "
+        << readCPUInfo().size() << " cpus" << std::endl;
+    return out.str();
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <archive>" << std::endl;
+        return 1;
+    }
+
+    std::shared_ptr<RecordingBackend> recording = std::make_shared<RecordingBackend>();
+    setProcBackend(recording);
+    std::string recorded = scan();
+    recording->save(argv[1]);
+    std::cout << recording->size() << " paths recorded" << std::endl;
+
+    std::shared_ptr<ReplayBackend> replay = std::make_shared<ReplayBackend>(argv[1]);
+    setProcBackend(replay);
+    std::string replayed = scan();
+    std::cout << replay->size() << " paths replayed" << std::endl;
+
+    if (recorded != replayed)
+    {
+        std::cout << "MISMATCH" << std::endl << recorded << std::endl << replayed;
+        return 1;
+    }
+    std::cout << recorded;
+    return 0;
+}
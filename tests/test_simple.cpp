@@ -14,7 +14,7 @@ int main()
 
     // display basic information for each one
     std::vector<ProcessInfo> process_list = processList();
-    for (ProcessInfo pinfo : process_list)
+    for (ProcessInfo& pinfo : process_list)
         std::cout << pinfo << std::endl;
 
     ProcessInfo pinfo(pid);
@@ -0,0 +1,40 @@
+#include <iostream>
+#include <unistd.h>
+#include <sysinfo.h>
+#include <snapshot.h>
+
+// usage: test_snapshot <file> [nb_snapshots]
+// appends nb_snapshots snapshots of the process table, then reads the file back
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <file> [nb_snapshots]" << std::endl;
+        return 1;
+    }
+    int nb_snapshots = argc > 2 ? atoi(argv[2]) : 3;
+    {
+        SnapshotWriter writer(argv[1]);
+        for (int i = 0; i < nb_snapshots; i++)
+        {
+            std::vector<ProcessInfo> processes = processList(SNAPSHOT_FIELDS);
+            writer.write(processes);
+            sleep(1);
+        }
+    }
+
+    SnapshotReader reader(argv[1]);
+    std::cout << reader.size() << " snapshots" << std::endl;
+    for (size_t i = 0; i < reader.size(); i++)
+    {
+        struct snapshot_view_t snapshot = reader.at(i);
+        std::cout << "[" << snapshot.timestamp.count() << "] " << snapshot.count << " processes, "
+                  << snapshot.strings_size << " B of strings" << std::endl;
+        for (size_t j = 0; j < snapshot.count && j < 5; j++)
+        {
+            const struct process_record_t& record = snapshot.records[j];
+            std::cout << "  " << record.pid << " " << record.state << " " << snapshot.string(record.name)
+                      << " rss " << record.vm_rss << " kB, " << snapshot.string(record.cmdline) << std::endl;
+        }
+    }
+}
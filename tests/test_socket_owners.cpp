@@ -0,0 +1,45 @@
+#include <iostream>
+#include <cstdlib>
+
+#include <sysinfo.h>
+#include <socketindex.h>
+
+int main(int argc, char* argv[])
+{
+    // optional port filter
+    int port = -1;
+    if (argc == 2)
+        port = atoi(argv[1]);
+
+    SocketIndex index;
+    index.build();
+    std::cout << "socket inodes : " << index.size() << std::endl;
+
+    std::vector<struct tcp_socket_t> tcp_socket_list = getSocketTCP();
+    index.attach(tcp_socket_list);
+    for (const struct tcp_socket_t& tcp_sock : tcp_socket_list)
+    {
+        if (port != -1 && tcp_sock.local_port != port)
+            continue;
+        std::cout << tcp_sock.local_address << ":" << tcp_sock.local_port << " "
+                  << tcp_sock.rem_address << ":" << tcp_sock.rem_port
+                  << " inode " << tcp_sock.inode << " ->";
+        for (const struct socket_owner_t& owner : tcp_sock.owners)
+            std::cout << " " << owner.pid << "[" << owner.fd << "]";
+        std::cout << std::endl;
+    }
+
+    if (port == -1)
+    {
+        std::vector<struct unix_socket_t> unix_socket_list = getSocketUNIX();
+        index.attach(unix_socket_list);
+        for (const struct unix_socket_t& unix_sock : unix_socket_list)
+        {
+            std::cout << "unix " << unix_sock.inode << " " << unix_sock.path << " ->";
+            for (const struct socket_owner_t& owner : unix_sock.owners)
+                std::cout << " " << owner.pid << "[" << owner.fd << "]";
+            std::cout << std::endl;
+        }
+    }
+    return 0;
+}
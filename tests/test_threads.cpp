@@ -0,0 +1,23 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <unistd.h>
+#include <threadmonitor.h>
+
+int main(int argc, char* argv[])
+{
+    pid_t pid = argc > 1 ? atoi(argv[1]) : getpid();
+    ThreadMonitor monitor(pid);
+    while (monitor.sample())
+    {
+        std::vector<struct thread_info_t> threads = monitor.threads();
+        std::sort(threads.begin(), threads.end(),
+                  [](const struct thread_info_t& a, const struct thread_info_t& b) { return a.cpu_usage > b.cpu_usage; });
+        std::cout << threads.size() << " threads" << std::endl;
+        for (size_t i = 0; i < threads.size() && i < 10; i++)
+            std::cout << std::setw(8) << threads[i].tid << " " << threads[i].state << " cpu" << threads[i].processor
+                      << " " << std::fixed << std::setprecision(1) << threads[i].cpu_usage << "% " << threads[i].name << std::endl;
+        sleep(1);
+    }
+}
@@ -0,0 +1,25 @@
+#include <iostream>
+#include <iomanip>
+#include <unistd.h>
+#include <sysinfo.h>
+
+// usage: test_topk [k]
+// top style refresh of the processes using the most cpu, then the largest
+int main(int argc, char* argv[])
+{
+    size_t k = argc > 1 ? atoi(argv[1]) : 10;
+
+    // first sample of the cpu usage
+    topProcesses(RANK_CPU, k);
+    sleep(1);
+    std::cout << "top " << k << " by cpu" << std::endl;
+    for (ProcessInfo& pinfo : topProcesses(RANK_CPU, k, FIELD_CMDLINE))
+        std::cout << std::setw(8) << pinfo.pid() << std::setw(5) << pinfo.cpuUsage() << "% " << pinfo.name()
+                  << std::endl;
+
+    std::cout << "top " << k << " by rss" << std::endl;
+    long page_kb = sysconf(_SC_PAGESIZE) / 1024;
+    for (ProcessInfo& pinfo : topProcesses(RANK_RSS, k, FIELD_STATUS))
+        std::cout << std::setw(8) << pinfo.pid() << std::setw(10) << pinfo.rss() * page_kb << " kB "
+                  << std::setw(10) << pinfo.vmRss() << " kB " << pinfo.name() << std::endl;
+}
@@ -0,0 +1,39 @@
+#include <cstdlib>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <sysinfo.h>
+#include <ttyindex.h>
+
+// opens a pty after the index was built and checks that its name resolves
+int main()
+{
+    // build the index first
+    std::cout << "self : '" << ProcessInfo(getpid()).ttyNr() << "'" << std::endl;
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master == -1 || grantpt(master) != 0 || unlockpt(master) != 0)
+    {
+        std::cerr << "cannot open a pty" << std::endl;
+        return 1;
+    }
+    std::string expected = ptsname(master);
+    struct stat st;
+    if (stat(expected.c_str(), &st) != 0)
+    {
+        std::cerr << "cannot stat " << expected << std::endl;
+        return 1;
+    }
+
+    std::string name = TtyIndex::instance().name(st.st_rdev);
+    std::cout << expected << " -> '" << name << "'" << std::endl;
+    close(master);
+    if (name != expected)
+    {
+        std::cerr << "FAILED" << std::endl;
+        return 1;
+    }
+    std::cout << "OK" << std::endl;
+    return 0;
+}
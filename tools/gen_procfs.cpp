@@ -0,0 +1,305 @@
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <getopt.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Writes a synthetic procfs tree, to run the library against a given
+// number of processes, threads, mappings and sockets with
+// setProcRoot(<output>)
+//
+// usage: gen_procfs [options] <output>
+//   -p, --processes N   processes (default 1000)
+//   -t, --threads M     threads per process, including the main one (default 4)
+//   -m, --mappings K    memory mappings per process (default 32)
+//   -f, --fds F         file descriptors per process (default 16)
+//   -s, --sockets S     sockets per process, among the fds (default 4)
+//   -c, --cpus C        cpus in cpuinfo (default 8)
+
+struct options_t
+{
+    int processes;
+    int threads;
+    int mappings;
+    int fds;
+    int sockets;
+    int cpus;
+    std::string output;
+};
+
+static void fail(const std::string& what)
+{
+    std::cerr << what << ": " << strerror(errno) << std::endl;
+    exit(1);
+}
+
+static void makeDir(const std::string& path)
+{
+    if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST)
+        fail(path);
+}
+
+static void writeFile(const std::string& path, const std::string& content)
+{
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == nullptr)
+        fail(path);
+    fwrite(content.data(), 1, content.size(), file);
+    fclose(file);
+}
+
+static void makeLink(const std::string& target, const std::string& path)
+{
+    unlink(path.c_str());
+    if (symlink(target.c_str(), path.c_str()) != 0)
+        fail(path);
+}
+
+static std::string format(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+
+static std::string format(const char* fmt, ...)
+{
+    char buf[1024];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    return buf;
+}
+
+// first socket inode of a process
+static unsigned long socketInode(int index, const struct options_t& options)
+{
+    return 100000 + static_cast<unsigned long>(index) * options.sockets;
+}
+
+static std::string statContent(int pid, int ppid, const std::string& name, int nb_threads, int seed)
+{
+    return format("%d (%s) S %d %d %d 0 -1 4194560 %d 0 %d 0 %d %d 0 0 20 0 %d 0 %d %d %d "
+                  "18446744073709551615 94213452103680 94213452756197 140733905417744 0 0 0 0 0 0 0 0 0 "
+                  "17 %d 0 0 %d 0 0 94213452971696 94213452995528 94213478932480 140733905425713 "
+                  "140733905425995 140733905425995 140733905428451 0\n",
+                  pid, name.c_str(), ppid, pid, ppid,
+                  1000 + seed % 5000, seed % 100, 100 + seed % 10000, 10 + seed % 1000, nb_threads,
+                  1000 + seed, 100000000 + seed * 4096, 2000 + seed % 50000,
+                  seed % 8, seed % 10);
+}
+
+static std::string statusContent(int pid, int ppid, const std::string& name, int nb_threads, int seed)
+{
+    int uid = seed % 3 == 0 ? 0 : 1000 + seed % 5;
+    int rss = 2000 + seed % 50000;
+    return format("Name:\t%s\nUmask:\t0022\nState:\tS (sleeping)\nTgid:\t%d\nNgid:\t0\nPid:\t%d\nPPid:\t%d\n"
+                  "TracerPid:\t0\nUid:\t%d\t%d\t%d\t%d\nGid:\t%d\t%d\t%d\t%d\nFDSize:\t64\nGroups:\t\n"
+                  "VmPeak:\t  %d kB\nVmSize:\t  %d kB\nVmLck:\t       0 kB\nVmPin:\t       0 kB\n"
+                  "VmHWM:\t  %d kB\nVmRSS:\t  %d kB\nRssAnon:\t  %d kB\nRssFile:\t  %d kB\nRssShmem:\t       0 kB\n"
+                  "VmData:\t  %d kB\nVmStk:\t     132 kB\nVmExe:\t     640 kB\nVmLib:\t    8192 kB\n"
+                  "VmPTE:\t     120 kB\nVmSwap:\t       0 kB\nThreads:\t%d\n"
+                  "voluntary_ctxt_switches:\t%d\nnonvoluntary_ctxt_switches:\t%d\n",
+                  name.c_str(), pid, pid, ppid, uid, uid, uid, uid, uid, uid, uid, uid,
+                  rss * 3, rss * 2, rss + 100, rss, rss / 2, rss / 2, rss, nb_threads,
+                  seed * 7 % 100000, seed * 3 % 1000);
+}
+
+static std::string ioContent(int seed)
+{
+    return format("rchar: %d\nwchar: %d\nsyscr: %d\nsyscw: %d\nread_bytes: %d\nwrite_bytes: %d\n"
+                  "cancelled_write_bytes: 0\n",
+                  seed * 4096, seed * 2048, seed * 10, seed * 5, seed * 512, seed * 256);
+}
+
+static std::string limitsContent()
+{
+    return "Limit                     Soft Limit           Hard Limit           Units     \n"
+           "Max cpu time              unlimited            unlimited            seconds   \n"
+           "Max file size             unlimited            unlimited            bytes     \n"
+           "Max data size             unlimited            unlimited            bytes     \n"
+           "Max stack size            8388608              unlimited            bytes     \n"
+           "Max core file size        0                    unlimited            bytes     \n"
+           "Max resident set          unlimited            unlimited            bytes     \n"
+           "Max processes             63413                63413                processes \n"
+           "Max open files            1024                 1048576              files     \n"
+           "Max locked memory         8388608              8388608              bytes     \n"
+           "Max address space         unlimited            unlimited            bytes     \n"
+           "Max file locks            unlimited            unlimited            locks     \n"
+           "Max pending signals       63413                63413                signals   \n"
+           "Max msgqueue size         819200               819200               bytes     \n"
+           "Max nice priority         0                    0                    \n"
+           "Max realtime priority     0                    0                    \n"
+           "Max realtime timeout      unlimited            unlimited            us        \n";
+}
+
+static std::string smapsContent(int nb_mappings, int seed)
+{
+    std::string smaps;
+    unsigned long address = 0x555555554000UL;
+    for (int i = 0; i < nb_mappings; i++)
+    {
+        unsigned long size = 4096UL * (1 + (seed + i) % 64);
+        // a few shared libraries, then anonymous memory
+        std::string path;
+        if (i % 4 == 0)
+            path = format("/usr/lib/x86_64-linux-gnu/libsynthetic%d.so", i % 20);
+        else if (i % 4 == 1)
+            path = "[heap]";
+        smaps += format("%lx-%lx %s %08lx fe:00 %d                     %s\n",
+                        address, address + size, i % 2 ? "rw-p" : "r-xp", 0UL, path.empty() ? 0 : 400000 + i % 20,
+                        path.c_str());
+        unsigned long kb = size / 1024;
+        smaps += format("Size:           %8lu kB\nKernelPageSize:        4 kB\nMMUPageSize:           4 kB\n"
+                        "Rss:            %8lu kB\nPss:            %8lu kB\nPss_Dirty:      %8lu kB\n"
+                        "Shared_Clean:   %8lu kB\nShared_Dirty:          0 kB\nPrivate_Clean:         0 kB\n"
+                        "Private_Dirty:  %8lu kB\nReferenced:     %8lu kB\nAnonymous:      %8lu kB\n"
+                        "KSM:                   0 kB\nLazyFree:              0 kB\nAnonHugePages:         0 kB\n"
+                        "ShmemPmdMapped:        0 kB\nFilePmdMapped:         0 kB\nShared_Hugetlb:        0 kB\n"
+                        "Private_Hugetlb:       0 kB\nSwap:                  0 kB\nSwapPss:               0 kB\n"
+                        "Locked:                0 kB\nTHPeligible:           0\nVmFlags: rd wr mr mw me ac sd\n",
+                        kb, kb / 2, kb / 4, kb / 4, kb / 2, kb / 2, kb / 2, path.empty() ? kb / 2 : 0);
+        address += size + 4096;
+    }
+    return smaps;
+}
+
+static void writeProcess(int index, const struct options_t& options)
+{
+    int pid = 1000 + index * options.threads;
+    int ppid = index == 0 ? 0 : 1000 + (index - 1) / 4 * options.threads;
+    std::string name = format("synthetic-%d", index);
+    std::string dir = options.output + "/" + std::to_string(pid);
+    makeDir(dir);
+
+    writeFile(dir + "/stat", statContent(pid, ppid, name, options.threads, index));
+    writeFile(dir + "/status", statusContent(pid, ppid, name, options.threads, index));
+    writeFile(dir + "/io", ioContent(index));
+    writeFile(dir + "/limits", limitsContent());
+    writeFile(dir + "/smaps", smapsContent(options.mappings, index));
+    writeFile(dir + "/wchan", "do_epoll_wait");
+    writeFile(dir + "/cgroup", format("0::/system.slice/synthetic-%d.service\n", index % 50));
+    writeFile(dir + "/stack", "[<0>] do_epoll_wait+0x4a0/0x4e0\n[<0>] __x64_sys_epoll_wait+0x6f/0x110\n");
+    std::string cmdline = "/usr/bin/" + name + std::string("\0--config\0/etc/synthetic.conf\0", 29);
+    writeFile(dir + "/cmdline", cmdline);
+    writeFile(dir + "/environ", std::string("PATH=/usr/bin:/bin\0HOME=/root\0LANG=C.UTF-8\0", 44));
+    makeLink("/", dir + "/cwd");
+    makeLink("/", dir + "/root");
+    makeLink("/usr/bin/" + name, dir + "/exe");
+
+    makeDir(dir + "/fd");
+    int nb_sockets = options.sockets < options.fds ? options.sockets : options.fds;
+    for (int fd = 0; fd < options.fds; fd++)
+    {
+        std::string target;
+        if (fd < 3)
+            target = "/dev/null";
+        else if (fd - 3 < nb_sockets)
+            target = format("socket:[%lu]", socketInode(index, options) + fd - 3);
+        else if (fd % 3 == 0)
+            target = format("pipe:[%d]", 50000 + index * options.fds + fd);
+        else
+            target = format("/var/log/synthetic-%d-%d.log", index, fd);
+        makeLink(target, dir + "/fd/" + std::to_string(fd));
+    }
+
+    makeDir(dir + "/task");
+    for (int thread = 0; thread < options.threads; thread++)
+    {
+        int tid = pid + thread;
+        std::string task_dir = dir + "/task/" + std::to_string(tid);
+        makeDir(task_dir);
+        std::string thread_name = thread == 0 ? name : format("worker-%d", thread);
+        writeFile(task_dir + "/stat", statContent(tid, ppid, thread_name, options.threads, index + thread));
+    }
+}
+
+static void writeGlobal(const struct options_t& options)
+{
+    writeFile(options.output + "/stat",
+              format("cpu  %d 0 %d %d 216 0 2 752 0 0\n", options.processes * 100, options.processes * 20,
+                     options.processes * 1000));
+
+    std::string cpuinfo;
+    for (int cpu = 0; cpu < options.cpus; cpu++)
+        cpuinfo += format("processor\t: %d\nvendor_id\t: GenuineIntel\ncpu family\t: 6\nmodel\t\t: 143\n"
+                          "model name\t: Synthetic CPU\nstepping\t: 8\nmicrocode\t: 0x1\ncpu MHz\t\t: 2000.000\n"
+                          "cache size\t: 107520 KB\nphysical id\t: 0\nsiblings\t: %d\ncore id\t\t: %d\n"
+                          "cpu cores\t: %d\napicid\t\t: %d\ninitial apicid\t: %d\nfpu\t\t: yes\n"
+                          "fpu_exception\t: yes\ncpuid level\t: 32\nwp\t\t: yes\nflags\t\t: fpu vme de pse tsc\n"
+                          "bugs\t\t: spectre_v1\nbogomips\t: 4000.00\nclflush size\t: 64\n"
+                          "cache_alignment\t: 64\naddress sizes\t: 46 bits physical, 57 bits virtual\n"
+                          "power management:\n\n",
+                          cpu, options.cpus, cpu, options.cpus, cpu, cpu);
+    writeFile(options.output + "/cpuinfo", cpuinfo);
+
+    // half of the sockets are tcp, the others unix
+    makeDir(options.output + "/net");
+    std::string tcp = "  sl  local_address rem_address   st tx_queue rx_queue tr tm->when retrnsmt   uid  timeout inode\n";
+    std::string unix_sockets = "Num       RefCount Protocol Flags    Type St Inode Path\n";
+    int sl = 0;
+    for (int index = 0; index < options.processes; index++)
+    {
+        for (int i = 0; i < options.sockets && i < options.fds; i++)
+        {
+            unsigned long inode = socketInode(index, options) + i;
+            if (i % 2 == 0)
+                tcp += format("%4d: 0100007F:%04X 0100007F:%04X 01 00000000:00000000 00:00000000 00000000  1000"
+                              "        0 %lu 1 0000000000000000 20 4 30 10 -1\n",
+                              sl++, 10000 + (index * 7 + i) % 50000, 443, inode);
+            else
+                unix_sockets += format("0000000000000000: 00000003 00000000 00000000 0001 03 %lu"
+                                       " /run/synthetic-%d.sock\n",
+                                       inode, index);
+        }
+    }
+    writeFile(options.output + "/net/tcp", tcp);
+    writeFile(options.output + "/net/unix", unix_sockets);
+}
+
+int main(int argc, char* argv[])
+{
+    struct options_t options = {1000, 4, 32, 16, 4, 8, ""};
+    static const struct option long_options[] = {
+        {"processes", required_argument, nullptr, 'p'},
+        {"threads", required_argument, nullptr, 't'},
+        {"mappings", required_argument, nullptr, 'm'},
+        {"fds", required_argument, nullptr, 'f'},
+        {"sockets", required_argument, nullptr, 's'},
+        {"cpus", required_argument, nullptr, 'c'},
+        {nullptr, 0, nullptr, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "p:t:m:f:s:c:", long_options, nullptr)) != -1)
+    {
+        switch (opt)
+        {
+        case 'p': options.processes = atoi(optarg); break;
+        case 't': options.threads = atoi(optarg); break;
+        case 'm': options.mappings = atoi(optarg); break;
+        case 'f': options.fds = atoi(optarg); break;
+        case 's': options.sockets = atoi(optarg); break;
+        case 'c': options.cpus = atoi(optarg); break;
+        default:
+            std::cerr << "usage: " << argv[0] << " [-p processes] [-t threads] [-m mappings] [-f fds]"
+                      << " [-s sockets] [-c cpus] <output>" << std::endl;
+            return 1;
+        }
+    }
+    if (optind != argc - 1 || options.threads < 1 || options.fds < 3)
+    {
+        std::cerr << "usage: " << argv[0] << " [-p processes] [-t threads] [-m mappings] [-f fds]"
+                  << " [-s sockets] [-c cpus] <output>" << std::endl;
+        return 1;
+    }
+    options.output = argv[optind];
+    makeDir(options.output);
+
+    writeGlobal(options);
+    for (int index = 0; index < options.processes; index++)
+        writeProcess(index, options);
+    std::cout << options.processes << " processes written to " << options.output << std::endl;
+    return 0;
+}